@@ -32,10 +32,18 @@ If you are selecting a link it will delete that instead of an object.
 The following commands need a control key held down to function:
 -Key 'B' to delete all connections from and to a selected object.
 -Key 'T' will rename the selected object to your clipboard contents.
+-Key 'R' will give the selected empty object an arena holding everything later added or pasted beneath it, so deleting it frees memory in whole slabs.
+-Key 'G' will grab the selected object. Selecting another object and pressing it again moves the grabbed object and everything in it there, keeping its links unless it changes depth.
 -Key 'C' will copy the selected object and recursively for its sub-objects as text data into your clipboard.
 -Key 'X' will do the above then delete it (Cut).
--Key 'V' will paste the text data recursively as a new object contained by the selected object.
+-Key 'V' will paste the text data recursively as a new object contained by the selected object. Pasting what was copied in this session copies it directly instead, keeping positions.
 -Key 'A' will advance the selected link's end object to its neighboring one in its stead.
+-Key 'M' will compact memory so objects and links are laid out in drawing order. This also happens on its own after heavy editing.
+-Key 'U' will toggle an overlay with the memory held by everything and by the selected object, now and at its peak.
+-Key 'D' will print the memory held by the selected object and its sub-objects two levels down to the console.
+-Key 'S' will take a snapshot of everything, costing nothing until later edits copy what they touch.
+-Key 'L' will copy everything as it was at the last snapshot as text data into your clipboard.
+-Key 'Z' will undo the last edit, and key 'Y' will redo it. Deleted objects are kept until they can no longer be brought back.
 Holding a shift key will always select the object you right clicked, and if you added the object it will move you down to it's depth.
 If you hold a shift key while left clicking an object, you will go to its depth.
 */
@@ -45,244 +53,1755 @@ If you hold a shift key while left clicking an object, you will go to its depth.
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <time.h>
 
-// This enum acts as a countdown to make sure links of an object are deleted in exactly two frames for object deletion and link breaking.
-enum
+// 1. A Monad cannot have multiple container Monads.
+// 2. rootSubLink can only have starting Monads that exist within rootSubMonads.
+// 3. A Link cannot comprise of Monads of different depths.
+// 4. Only one combination of a Link can exist in totality.
+#define MAX_MONAD_NAME_SIZE 32 // longest part of a name written into the action log, names themselves are unbounded.
+#define MONAD_LINK_MIDDLE_LERP 0.35f
+
+// Objects, links and arenas refer to each other by 32-bit handles into typed tables instead of pointers. Handle 0 is null.
+typedef unsigned int MonadId;
+typedef unsigned int LinkId;
+typedef unsigned int ArenaId;
+
+// Names shorter than 8 bytes are kept inline. Longer names are interned once in MonadNames and referenced by offset.
+#define MONAD_NAME_INLINE 7
+#define MONAD_NAME_INTERNED 0xFFFFFFFF
+typedef union MonadName
+{
+    char text[MONAD_NAME_INLINE + 1]; // inline form, the last byte is always zero.
+    struct
+    {
+        unsigned int offset;
+        unsigned int tag; // MONAD_NAME_INTERNED, which sets the last byte.
+    } interned;
+} MonadName;
+
+typedef struct Link
+{
+    MonadId startMonad;
+    MonadId endMonad;
+    LinkId next;
+    LinkId prev; // the link ring runs both ways so any link unlinks in constant time.
+    MonadId container; // the Monad whose rootSubLink ring holds the link.
+    LinkId nextAt[2]; // rings of the links leaving (LINK_OUT) and entering (LINK_IN) each end, indexed by LinkEnd.
+    LinkId prevAt[2];
+} Link;
+
+enum LinkEnd
+{
+    LINK_OUT, // keyed on startMonad.
+    LINK_IN // keyed on endMonad.
+};
+
+enum Response
+{
+    RESULT_NONE,
+    RESULT_CLICK,
+    RESULT_RCLICK
+};
+
+// After returning recursively up the chain, certain results can override other results depending on the situation.
+typedef struct ActiveResult
+{
+    MonadId resultMonad;
+    MonadId resultContainerMonad;
+    LinkId resultLink;
+    unsigned int resultDepth;
+    char resultKey;
+} ActiveResult;
+
+// Every node lives in a fixed-size slab of a table. A handle is the slab index shifted up, plus the slot in that slab.
+// Slab 0 is never handed out so that handle 0 stays null.
+#define SLAB_SHIFT 8
+#define SLAB_NODES (1 << SLAB_SHIFT)
+#define SLAB_MASK (SLAB_NODES - 1)
+
+// Monads are stored as columns so whole-tree passes only pull in the fields they touch.
+// Hot columns come first, the name and memory accounting are kept apart at the end of the slab.
+typedef struct MonadSlab
+{
+    Vector2 position[SLAB_NODES];
+    MonadId rootSubMonads[SLAB_NODES];
+    MonadId next[SLAB_NODES];
+    MonadId prev[SLAB_NODES]; // the sibling ring runs both ways so any object unlinks in constant time.
+    LinkId rootSubLink[SLAB_NODES];
+    LinkId endLinks[SLAB_NODES][2]; // any link leaving or entering the Monad, indexed by LinkEnd, wherever it is held.
+    unsigned int depth[SLAB_NODES];
+    MonadName name[SLAB_NODES];
+    ArenaId arena[SLAB_NODES]; // where sub-objects and links are allocated from, 0 for the global pools.
+    MonadId container[SLAB_NODES]; // containing Monad, 0 for the root.
+    unsigned int subtreeMonads[SLAB_NODES]; // live objects in the subtree, the Monad itself included.
+    unsigned int subtreeLinks[SLAB_NODES]; // live links held by the Monad and its sub-objects.
+    size_t peakBytes[SLAB_NODES]; // highest SubtreeBytes() the subtree reached.
+    unsigned int subCount[SLAB_NODES]; // sub-objects directly inside.
+} MonadSlab;
+
+typedef struct SlabTable
+{
+    char** slabs; // a shared block like each slab in it, see SlabHeader.
+    unsigned int slabCount;
+    unsigned int slabCapacity;
+    unsigned int* releasedSlabs; // indices of freed slabs, reused before the table grows.
+    unsigned int releasedCount;
+    unsigned int releasedCapacity;
+    size_t slabSize;
+    size_t freeLinkOffset; // where a free node keeps the handle of the next free one.
+    size_t freeLinkStride;
+} SlabTable;
+
+SlabTable MonadTable = { .slabSize = sizeof(MonadSlab) , .freeLinkOffset = offsetof(MonadSlab, next) , .freeLinkStride = sizeof(MonadId) };
+SlabTable LinkTable = { .slabSize = sizeof(Link) * SLAB_NODES , .freeLinkOffset = offsetof(Link, next) , .freeLinkStride = sizeof(Link) };
+unsigned int LiveSlabCount = 0;
+unsigned int NodeChurn = 0; // nodes freed since the last compaction.
+unsigned int SlabCopies = 0; // slabs and slab lists copied because a snapshot still shared them.
+unsigned int SnapshotCount = 0; // snapshots and views alive. While there are none every block has the live tables as its only holder.
+
+// Slabs and slab lists are shared between the live tables and any snapshot taken of them. Each block counts its holders in a header in front of it,
+// and the live tables copy a block before writing to it while anyone else holds it. Reads never copy, writes must go through MONAD_W and LINK_W.
+typedef union SlabHeader
+{
+    unsigned int holders;
+    max_align_t align; // keeps the block behind the header aligned for any column.
+} SlabHeader;
+
+#define SLAB_HOLDERS(block) (((SlabHeader*)(block) - 1)->holders)
+
+void* NewSharedBlock(size_t size)
+{
+    SlabHeader* header = calloc(1, sizeof(SlabHeader) + size);
+    header->holders = 1;
+    return header + 1;
+}
+
+void DropSharedBlock(void* block)
+{
+    if (block && !--SLAB_HOLDERS(block))
+        free((SlabHeader*)block - 1);
+}
+
+// Lets go of a slab list, and of every slab in it once nothing else holds the list.
+void DropSlabList(char** slabs, unsigned int slabCount)
+{
+    if (!slabs || --SLAB_HOLDERS(slabs))
+        return;
+    for (unsigned int i = 0; i < slabCount; i++)
+        DropSharedBlock(slabs[i]);
+    free((SlabHeader*)slabs - 1);
+}
+
+// Gives the table a slab list of its own with room for capacity slabs. The slabs themselves stay shared.
+void OwnSlabList(SlabTable* table, unsigned int capacity)
+{
+    if (table->slabs && SLAB_HOLDERS(table->slabs) == 1) //already private, growing in place is enough.
+    {
+        SlabHeader* header = realloc((SlabHeader*)table->slabs - 1, sizeof(SlabHeader) + capacity * sizeof(char*));
+        table->slabs = (char**)(header + 1);
+        table->slabCapacity = capacity;
+        return;
+    }
+
+    char** slabs = NewSharedBlock(capacity * sizeof(char*));
+    for (unsigned int i = 0; i < table->slabCount; i++)
+    {
+        slabs[i] = table->slabs[i];
+        if (slabs[i])
+            SLAB_HOLDERS(slabs[i])++;
+    }
+    if (table->slabs)
+    {
+        SLAB_HOLDERS(table->slabs)--; //still held by a snapshot, which keeps its slabs too.
+        SlabCopies++;
+    }
+    table->slabs = slabs;
+    table->slabCapacity = capacity;
+}
+
+char* OwnSlab(SlabTable* table, unsigned int slabIndex)
+{
+    if (SLAB_HOLDERS(table->slabs) > 1)
+        OwnSlabList(table, table->slabCapacity);
+    char* slab = table->slabs[slabIndex];
+    if (SLAB_HOLDERS(slab) > 1)
+    {
+        char* copy = NewSharedBlock(table->slabSize);
+        memcpy(copy, slab, table->slabSize);
+        DropSharedBlock(slab);
+        table->slabs[slabIndex] = slab = copy;
+        SlabCopies++;
+    }
+    return slab;
+}
+
+// Returns the slab, copied first if a snapshot still shares it or the list holding it.
+char* WritableSlab(SlabTable* table, unsigned int slabIndex)
+{
+    return SnapshotCount ? OwnSlab(table, slabIndex) : table->slabs[slabIndex];
+}
+
+#define MONAD(id, column) (((MonadSlab*)MonadTable.slabs[(id) >> SLAB_SHIFT])->column[(id) & SLAB_MASK])
+#define LINK(id) ((Link*)LinkTable.slabs[(id) >> SLAB_SHIFT] + ((id) & SLAB_MASK))
+#define MONAD_W(id, column) (((MonadSlab*)WritableSlab(&MonadTable, (id) >> SLAB_SHIFT))->column[(id) & SLAB_MASK])
+#define LINK_W(id) ((Link*)WritableSlab(&LinkTable, (id) >> SLAB_SHIFT) + ((id) & SLAB_MASK))
+#define MONAD_ROW_BYTES (sizeof(MonadSlab) / SLAB_NODES) // bytes one Monad takes across all columns.
+
+unsigned int* FreeLinkOf(SlabTable* table, unsigned int id)
+{
+    return (unsigned int*)(WritableSlab(table, id >> SLAB_SHIFT) + table->freeLinkOffset + table->freeLinkStride * (id & SLAB_MASK));
+}
+
+unsigned int AcquireSlab(SlabTable* table)
+{
+    if (!table->slabs || SLAB_HOLDERS(table->slabs) > 1)
+        OwnSlabList(table, table->slabCapacity ? table->slabCapacity : 16);
+    unsigned int slabIndex;
+    if (table->releasedCount)
+    {
+        slabIndex = table->releasedSlabs[--table->releasedCount];
+    }
+    else
+    {
+        if (table->slabCount == table->slabCapacity)
+            OwnSlabList(table, table->slabCapacity * 2);
+        if (!table->slabCount) //reserve slab 0.
+            table->slabs[table->slabCount++] = NULL;
+        slabIndex = table->slabCount++;
+    }
+    table->slabs[slabIndex] = NewSharedBlock(table->slabSize);
+    LiveSlabCount++;
+    return slabIndex;
+}
+
+void ReleaseSlab(SlabTable* table, unsigned int slabIndex)
+{
+    if (SLAB_HOLDERS(table->slabs) > 1)
+        OwnSlabList(table, table->slabCapacity);
+    DropSharedBlock(table->slabs[slabIndex]);
+    table->slabs[slabIndex] = NULL;
+    if (table->releasedCount == table->releasedCapacity)
+    {
+        table->releasedCapacity = table->releasedCapacity ? table->releasedCapacity * 2 : 16;
+        table->releasedSlabs = realloc(table->releasedSlabs, table->releasedCapacity * sizeof(unsigned int));
+    }
+    table->releasedSlabs[table->releasedCount++] = slabIndex;
+    LiveSlabCount--;
+}
+
+// A pool hands out handles from the slabs it owns. Freed nodes are threaded into a free list for reuse, and a pool gives back all of its slabs at once.
+typedef struct NodePool
+{
+    SlabTable* table;
+    unsigned int* slabIds;
+    unsigned int slabCount;
+    unsigned int slabCapacity;
+    unsigned int bumpIndex; // next never used slot in the last slab.
+    unsigned int liveNodes;
+    unsigned int freeList; // first free handle, see freeLinkOffset for where the next one is kept.
+} NodePool;
+
+// Frees every slab of the pool in bulk. Any handle still allocated from it becomes invalid.
+void PoolReleaseAll(NodePool* pool)
+{
+    NodeChurn += pool->liveNodes;
+    for (unsigned int i = 0; i < pool->slabCount; i++)
+        ReleaseSlab(pool->table, pool->slabIds[i]);
+    free(pool->slabIds);
+    pool->slabIds = NULL;
+    pool->slabCount = pool->slabCapacity = pool->bumpIndex = pool->liveNodes = pool->freeList = 0;
+}
+
+// Takes the next never used slot, passing over the free list, so nodes taken one after another sit side by side.
+unsigned int PoolBump(NodePool* pool)
+{
+    if (!pool->slabCount || pool->bumpIndex == SLAB_NODES) //current slab is used up.
+    {
+        if (pool->slabCount == pool->slabCapacity)
+        {
+            pool->slabCapacity = pool->slabCapacity ? pool->slabCapacity * 2 : 4;
+            pool->slabIds = realloc(pool->slabIds, pool->slabCapacity * sizeof(unsigned int));
+        }
+        pool->slabIds[pool->slabCount++] = AcquireSlab(pool->table);
+        pool->bumpIndex = 0;
+    }
+    pool->liveNodes++;
+    return (pool->slabIds[pool->slabCount - 1] << SLAB_SHIFT) | pool->bumpIndex++;
+}
+
+unsigned int PoolAlloc(NodePool* pool)
+{
+    unsigned int id = pool->freeList;
+    if (!id)
+        return PoolBump(pool);
+
+    //reuse a freed node.
+    pool->freeList = *FreeLinkOf(pool->table, id);
+    pool->liveNodes++;
+    return id;
+}
+
+// Returns a node to the free list. Once the last node of a pool is freed all of its slabs are released.
+void PoolFree(NodePool* pool, unsigned int id)
+{
+    *FreeLinkOf(pool->table, id) = pool->freeList;
+    pool->freeList = id;
+    NodeChurn++;
+    if (!--pool->liveNodes)
+        PoolReleaseAll(pool);
+}
+
+// An arena makes a container own the memory of every object and link beneath it, so deleting the container hands back whole slabs.
+// Arenas of containers nested inside another arena are chained to it and released along with it. Arena 0 holds the global pools.
+typedef struct MonadArena
+{
+    NodePool monads;
+    NodePool links;
+    MonadId owner;
+    ArenaId parentArena; // arena the owner itself lives in.
+    ArenaId subArenas;
+    ArenaId nextArena;
+    ArenaId prevArena;
+} MonadArena;
+
+MonadArena GlobalArena = { .monads = { .table = &MonadTable } , .links = { .table = &LinkTable } };
+MonadArena** ArenaTable = NULL;
+unsigned int ArenaCapacity = 0;
+
+MonadArena* ArenaOf(ArenaId arena)
+{
+    return arena ? ArenaTable[arena] : &GlobalArena;
+}
+
+NodePool* MonadPoolOf(ArenaId arena)
+{
+    return &ArenaOf(arena)->monads;
+}
+
+NodePool* LinkPoolOf(ArenaId arena)
+{
+    return &ArenaOf(arena)->links;
+}
+
+// Gives an empty container its own arena. Returns false if it already has sub-objects, links or an arena of its own.
+bool EnableMonadArena(MonadId monad)
+{
+    if (MONAD(monad, rootSubMonads) || MONAD(monad, rootSubLink) || (MONAD(monad, arena) && ArenaOf(MONAD(monad, arena))->owner == monad))
+        return false;
+
+    ArenaId newArena = 1;
+    while (newArena < ArenaCapacity && ArenaTable[newArena]) //arenas are rare, reuse the first free entry.
+        newArena++;
+    if (newArena >= ArenaCapacity)
+    {
+        unsigned int oldCapacity = ArenaCapacity;
+        ArenaCapacity = ArenaCapacity ? ArenaCapacity * 2 : 16;
+        ArenaTable = realloc(ArenaTable, ArenaCapacity * sizeof(MonadArena*));
+        memset(ArenaTable + oldCapacity, 0, (ArenaCapacity - oldCapacity) * sizeof(MonadArena*));
+    }
+
+    MonadArena* arena = (MonadArena*)malloc(sizeof(MonadArena));
+    memset(arena, 0, sizeof(MonadArena));
+    arena->monads.table = &MonadTable;
+    arena->links.table = &LinkTable;
+    arena->owner = monad;
+    arena->parentArena = MONAD(monad, arena);
+    ArenaTable[newArena] = arena;
+
+    MonadArena* parentArena = ArenaOf(arena->parentArena);
+    arena->nextArena = parentArena->subArenas;
+    if (parentArena->subArenas)
+        ArenaOf(parentArena->subArenas)->prevArena = newArena;
+    parentArena->subArenas = newArena;
+
+    MONAD_W(monad, arena) = newArena;
+    return true;
+}
+
+// Releases every slab of the arena and of the arenas nested in it. The owner itself is not freed.
+void ReleaseMonadArena(ArenaId arenaId)
+{
+    MonadArena* arena = ArenaOf(arenaId);
+    while (arena->subArenas)
+        ReleaseMonadArena(arena->subArenas);
+
+    if (arena->prevArena)
+        ArenaOf(arena->prevArena)->nextArena = arena->nextArena;
+    else
+        ArenaOf(arena->parentArena)->subArenas = arena->nextArena;
+    if (arena->nextArena)
+        ArenaOf(arena->nextArena)->prevArena = arena->prevArena;
+
+    PoolReleaseAll(&arena->monads);
+    PoolReleaseAll(&arena->links);
+    free(arena);
+    ArenaTable[arenaId] = NULL;
+}
+
+#define SCREENMARGIN 50
+
+bool IsVector2OnScreen(Vector2 pos)
+{
+    return pos.x >= SCREENMARGIN && pos.x <= GetScreenWidth() - SCREENMARGIN && pos.y >= SCREENMARGIN && pos.y <= GetScreenHeight() - SCREENMARGIN;
+}
+
+// Shared storage for every name too long to be inline. Identical names are stored once.
+typedef struct NameArena
+{
+    char* chars;
+    unsigned int used;
+    unsigned int capacity;
+    unsigned int* slots; // offset + 1 of each interned name, 0 when empty.
+    unsigned int slotCount;
+    unsigned int slotCapacity;
+} NameArena;
+
+NameArena MonadNames = { 0 };
+
+unsigned int HashName(const char* text, unsigned int length)
+{
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < length; i++)
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    return hash;
+}
+
+// Returns the offset of text in MonadNames, appending it if it has not been seen before.
+unsigned int InternName(const char* text, unsigned int length)
+{
+    if (MonadNames.slotCount * 2 >= MonadNames.slotCapacity) //keep the load under half, rehash into a table twice the size.
+    {
+        unsigned int oldCapacity = MonadNames.slotCapacity;
+        unsigned int* oldSlots = MonadNames.slots;
+        MonadNames.slotCapacity = oldCapacity ? oldCapacity * 2 : 64;
+        MonadNames.slots = calloc(MonadNames.slotCapacity, sizeof(unsigned int));
+        for (unsigned int i = 0; i < oldCapacity; i++)
+        {
+            if (!oldSlots[i])
+                continue;
+            const char* oldText = MonadNames.chars + oldSlots[i] - 1;
+            unsigned int slot = HashName(oldText, strlen(oldText)) & (MonadNames.slotCapacity - 1);
+            while (MonadNames.slots[slot])
+                slot = (slot + 1) & (MonadNames.slotCapacity - 1);
+            MonadNames.slots[slot] = oldSlots[i];
+        }
+        free(oldSlots);
+    }
+
+    unsigned int slot = HashName(text, length) & (MonadNames.slotCapacity - 1);
+    while (MonadNames.slots[slot])
+    {
+        const char* candidate = MonadNames.chars + MonadNames.slots[slot] - 1;
+        if (!strncmp(candidate, text, length) && candidate[length] == '\0')
+            return MonadNames.slots[slot] - 1;
+        slot = (slot + 1) & (MonadNames.slotCapacity - 1);
+    }
+
+    if (MonadNames.used + length + 1 > MonadNames.capacity)
+    {
+        while (MonadNames.used + length + 1 > MonadNames.capacity)
+            MonadNames.capacity = MonadNames.capacity ? MonadNames.capacity * 2 : 4096;
+        MonadNames.chars = realloc(MonadNames.chars, MonadNames.capacity);
+    }
+    unsigned int offset = MonadNames.used;
+    memcpy(MonadNames.chars + offset, text, length);
+    MonadNames.chars[offset + length] = '\0';
+    MonadNames.used += length + 1;
+    MonadNames.slots[slot] = offset + 1;
+    MonadNames.slotCount++;
+    return offset;
+}
+
+// A name being typed, kept out of MonadNames until the edit ends so only the finished name is interned.
+typedef struct NameEdit
+{
+    MonadId monad; // 0 when no name is being typed.
+    char* text;
+    unsigned int length;
+    unsigned int capacity;
+} NameEdit;
+
+NameEdit TypedName = { 0 };
+
+// The returned text of an interned name is only valid until the next name is interned, that of a typed one until the next keystroke.
+const char* MonadNameText(MonadId monad)
+{
+    if (TypedName.monad && monad == TypedName.monad)
+        return TypedName.text;
+    MonadName* name = &MONAD(monad, name);
+    if (name->text[MONAD_NAME_INLINE])
+        return MonadNames.chars + name->interned.offset;
+    return name->text;
+}
+
+// Names the object with length characters of text, which need not end there.
+void SetMonadNameLength(MonadId monad, const char* text, unsigned int length)
+{
+    MonadName* name = &MONAD_W(monad, name);
+    if (length <= MONAD_NAME_INLINE)
+    {
+        memset(name->text, 0, sizeof(name->text));
+        memcpy(name->text, text, length);
+    }
+    else
+    {
+        name->interned.offset = InternName(text, length);
+        name->interned.tag = MONAD_NAME_INTERNED;
+    }
+}
+
+void SetMonadName(MonadId monad, const char* text)
+{
+    SetMonadNameLength(monad, text, strlen(text));
+}
+
+// Writes at most MAX_MONAD_NAME_SIZE - 1 characters of the name onto the log.
+void AppendLogName(char* log, MonadId monad)
+{
+    strncat(log, MonadNameText(monad), MAX_MONAD_NAME_SIZE - 1);
+}
+
+// Every live link by its (start, end) pair, so a combination can only exist once in the whole tree.
+// Entries are checked against the link they name, one whose link has gone is skipped and dropped on the next rehash.
+typedef struct LinkPair
+{
+    MonadId startMonad;
+    MonadId endMonad;
+    LinkId link; // 0 when empty.
+} LinkPair;
+
+typedef struct LinkIndex
+{
+    LinkPair* slots;
+    unsigned int slotCount; // stale entries included.
+    unsigned int slotCapacity;
+} LinkIndex;
+
+LinkIndex LinkPairs = { 0 };
+
+unsigned int HashLinkPair(MonadId start, MonadId end)
+{
+    unsigned int hash = start * 2654435761u ^ end * 2246822519u;
+    return hash ^ (hash >> 15);
+}
+
+// An entry is stale once its slab was handed back or its node was reused by another pair.
+bool LinkPairIsLive(const LinkPair* pair)
+{
+    unsigned int slabIndex = pair->link >> SLAB_SHIFT;
+    if (slabIndex >= LinkTable.slabCount || !LinkTable.slabs[slabIndex])
+        return false;
+    Link* linkPtr = LINK(pair->link);
+    return linkPtr->startMonad == pair->startMonad && linkPtr->endMonad == pair->endMonad;
+}
+
+void RehashLinkPairs(void)
+{
+    unsigned int liveCount = 0;
+    for (unsigned int i = 0; i < LinkPairs.slotCapacity; i++)
+    {
+        if (LinkPairs.slots[i].link && LinkPairIsLive(&LinkPairs.slots[i]))
+            liveCount++;
+    }
+
+    unsigned int oldCapacity = LinkPairs.slotCapacity;
+    LinkPair* oldSlots = LinkPairs.slots;
+    LinkPairs.slotCapacity = 64;
+    while (LinkPairs.slotCapacity < liveCount * 4) //come out of a rehash at most a quarter full.
+        LinkPairs.slotCapacity *= 2;
+    LinkPairs.slots = calloc(LinkPairs.slotCapacity, sizeof(LinkPair));
+    LinkPairs.slotCount = liveCount;
+    for (unsigned int i = 0; i < oldCapacity; i++)
+    {
+        if (!oldSlots[i].link || !LinkPairIsLive(&oldSlots[i]))
+            continue;
+        unsigned int slot = HashLinkPair(oldSlots[i].startMonad, oldSlots[i].endMonad) & (LinkPairs.slotCapacity - 1);
+        while (LinkPairs.slots[slot].link)
+            slot = (slot + 1) & (LinkPairs.slotCapacity - 1);
+        LinkPairs.slots[slot] = oldSlots[i];
+    }
+    free(oldSlots);
+}
+
+// Returns the entry to fill in for the pair, or NULL if a live link already joins start to end.
+LinkPair* ClaimLinkPair(MonadId start, MonadId end)
+{
+    if (LinkPairs.slotCount * 2 >= LinkPairs.slotCapacity) //keep the load under half.
+        RehashLinkPairs();
+
+    unsigned int slot = HashLinkPair(start, end) & (LinkPairs.slotCapacity - 1);
+    while (LinkPairs.slots[slot].link)
+    {
+        LinkPair* pair = &LinkPairs.slots[slot];
+        if (pair->startMonad == start && pair->endMonad == end)
+            return LinkPairIsLive(pair) ? NULL : pair;
+        slot = (slot + 1) & (LinkPairs.slotCapacity - 1);
+    }
+    LinkPairs.slotCount++;
+    LinkPairs.slots[slot].startMonad = start;
+    LinkPairs.slots[slot].endMonad = end;
+    return &LinkPairs.slots[slot];
+}
+
+// Takes the pair out, shifting back the entries probed past it so no tombstones are needed.
+void UnindexLinkPair(MonadId start, MonadId end)
+{
+    if (!LinkPairs.slotCapacity)
+        return;
+    unsigned int mask = LinkPairs.slotCapacity - 1;
+    unsigned int hole = HashLinkPair(start, end) & mask;
+    while (LinkPairs.slots[hole].startMonad != start || LinkPairs.slots[hole].endMonad != end)
+    {
+        if (!LinkPairs.slots[hole].link)
+            return;
+        hole = (hole + 1) & mask;
+    }
+    if (!LinkPairs.slots[hole].link)
+        return;
+
+    unsigned int probe = hole;
+    while (LinkPairs.slots[probe = (probe + 1) & mask].link)
+    {
+        unsigned int home = HashLinkPair(LinkPairs.slots[probe].startMonad, LinkPairs.slots[probe].endMonad) & mask;
+        if (((probe - home) & mask) >= ((probe - hole) & mask))
+        {
+            LinkPairs.slots[hole] = LinkPairs.slots[probe];
+            hole = probe;
+        }
+    }
+    LinkPairs.slots[hole] = (LinkPair){ 0 };
+    LinkPairs.slotCount--;
+}
+
+// Returns the live link joining start to end, 0 if there is none.
+LinkId FindLinkPair(MonadId start, MonadId end)
+{
+    if (!LinkPairs.slotCapacity)
+        return 0;
+    unsigned int slot = HashLinkPair(start, end) & (LinkPairs.slotCapacity - 1);
+    while (LinkPairs.slots[slot].link)
+    {
+        LinkPair* pair = &LinkPairs.slots[slot];
+        if (pair->startMonad == start && pair->endMonad == end)
+            return LinkPairIsLive(pair) ? pair->link : 0;
+        slot = (slot + 1) & (LinkPairs.slotCapacity - 1);
+    }
+    return 0;
+}
+
+// Resets every column of a freshly allocated Monad.
+void ClearMonad(MonadId monad)
+{
+    MONAD_W(monad, position) = (Vector2){ 0 };
+    MONAD_W(monad, rootSubMonads) = 0;
+    MONAD_W(monad, next) = monad;
+    MONAD_W(monad, prev) = monad;
+    MONAD_W(monad, rootSubLink) = 0;
+    MONAD_W(monad, endLinks)[LINK_OUT] = 0;
+    MONAD_W(monad, endLinks)[LINK_IN] = 0;
+    MONAD_W(monad, depth) = 0;
+    memset(&MONAD_W(monad, name), 0, sizeof(MonadName));
+    MONAD_W(monad, arena) = 0;
+    MONAD_W(monad, container) = 0;
+    MONAD_W(monad, subCount) = 0;
+    MONAD_W(monad, subtreeMonads) = 1;
+    MONAD_W(monad, subtreeLinks) = 0;
+    MONAD_W(monad, peakBytes) = MONAD_ROW_BYTES;
+}
+
+// Bytes held by the objects and links of a subtree. Names are shared through MonadNames and not counted.
+size_t SubtreeBytes(MonadId monad)
+{
+    return (size_t)MONAD(monad, subtreeMonads) * MONAD_ROW_BYTES + (size_t)MONAD(monad, subtreeLinks) * sizeof(Link);
+}
+
+// Applies a change in objects and links to containingMonad and everything above it, raising peaks on the way.
+void AccountSubtree(MonadId containingMonad, int monadDelta, int linkDelta)
+{
+    for (MonadId iterator = containingMonad; iterator; iterator = MONAD(iterator, container))
+    {
+        MONAD_W(iterator, subtreeMonads) += monadDelta;
+        MONAD_W(iterator, subtreeLinks) += linkDelta;
+        size_t bytes = SubtreeBytes(iterator);
+        if (bytes > MONAD(iterator, peakBytes))
+            MONAD_W(iterator, peakBytes) = bytes;
+    }
+}
+
+// Prints what a subtree holds, then the same for its sub-objects down to maxLevel levels beneath it.
+void DumpMemoryUsageRecursive(MonadId monad, unsigned int level, unsigned int maxLevel)
+{
+    printf("%*s[%s] %u objects, %u links, %zu bytes, peak %zu bytes\n", (int)level * 2, "", MonadNameText(monad),
+        MONAD(monad, subtreeMonads), MONAD(monad, subtreeLinks), SubtreeBytes(monad), MONAD(monad, peakBytes));
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad && level < maxLevel)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            DumpMemoryUsageRecursive(iterator, level + 1, maxLevel);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// Draws the usage of a subtree as one line of the memory overlay.
+void DrawMemoryUsage(const char* label, MonadId monad, int posY)
+{
+    char usageText[128];
+    snprintf(usageText, sizeof(usageText), "%s: %u objects, %u links, %.1f KB (peak %.1f KB)", label,
+        MONAD(monad, subtreeMonads), MONAD(monad, subtreeLinks), SubtreeBytes(monad) / 1024.0, MONAD(monad, peakBytes) / 1024.0);
+    DrawText(usageText, 32, posY, 20, GRAY);
+}
+
+// Recursively frees the object after calling the function for its sub-objects. Its links must have been broken already.
+void  RemoveSubMonadsRecursive(MonadId monad)
+{
+    ArenaId arena = MONAD(monad, arena);
+    if (arena && ArenaOf(arena)->owner == monad) //everything beneath lives in the arena, no need to walk it.
+    {
+        ArenaId homeArena = ArenaOf(arena)->parentArena;
+        ReleaseMonadArena(arena);
+        PoolFree(MonadPoolOf(homeArena), monad);
+        return;
+    }
+
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            MonadId nextMonad = MONAD(iterator, next);
+            RemoveSubMonadsRecursive(iterator);
+            iterator = nextMonad;
+        } while (iterator != rootMonad);
+    }
+
+    PoolFree(MonadPoolOf(arena), monad);
+}
+
+// Every edit made while recording, oldest first, so it can be undone and redone a step at a time. Entries from done on have been undone.
+// Objects taken out of the tree by a done removal or an undone addition are kept allocated, the journal is all that still holds them.
+enum JournalOp
 {
-    DELETE_OFF,
-    DELETE_POSTONLYLINK,
-    DELETE_ONLYLINK,
-    DELETE_PRELINK,
-    DELETE_FINAL
+    JOURNAL_ADD_MONAD,
+    JOURNAL_REMOVE_MONAD,
+    JOURNAL_ADD_LINK,
+    JOURNAL_REMOVE_LINK,
+    JOURNAL_RENAME,
+    JOURNAL_MOVE,
+    JOURNAL_REPARENT
 };
 
-// 1. A Monad cannot have multiple container Monads.
-// 2. rootSubLink can only have starting Monads that exist within rootSubMonads.
-// 3. A Link cannot comprise of Monads of different depths.
-// 4. Only one combination of a Link can exist in totality.
-#define MAX_MONAD_NAME_SIZE 32
-#define MONAD_LINK_MIDDLE_LERP 0.35f
-typedef struct Monad
+typedef struct JournalEntry
+{
+    unsigned char op;
+    bool stepStart; // first entry of a user action.
+    bool wasRoot; // the object was the newest sub-object of its container, the link the oldest of its container.
+    MonadId monad; // start of a link.
+    MonadId mate; // end of a link, or the sibling before the object, 0 if it had none.
+    MonadId container; // for a reparent, the container on the other side, along with mate and wasRoot.
+    union
+    {
+        Vector2 position; // of the object for a move, of the container for an addition.
+        MonadName name;
+        struct
+        {
+            MonadId start;
+            MonadId end;
+        } prevLink; // link before a link in its container, both 0 if it had none. Links are put back anew, so they are known by their ends.
+    } swap; // value on the other side of the entry, exchanged with the current one on every undo and redo.
+} JournalEntry;
+
+typedef struct Journal
+{
+    JournalEntry* entries;
+    unsigned int count;
+    unsigned int done;
+    unsigned int capacity;
+    bool recording;
+    bool replaying; // undo and redo call the editing functions themselves, they must not record again.
+    bool stepPending;
+    bool sealed; // last entry may not take in another move of the same object, set once the drag making it ends.
+} Journal;
+
+#define JOURNAL_MAX_ENTRIES (1 << 20) // the oldest half of the steps is let go of beyond this.
+
+Journal MonadJournal = { 0 };
+
+// Whether an edit made now goes into the journal, in which case removed objects must be kept.
+bool JournalKeeps(void)
+{
+    return MonadJournal.recording && !MonadJournal.replaying;
+}
+
+// The next entry recorded starts a new step. Steps with nothing recorded in them do not exist.
+void BeginJournalStep(void)
+{
+    MonadJournal.stepPending = true;
+}
+
+// Objects held only by the entries are freed, undone additions newest first so nested ones go before the arena holding them.
+void DropJournalEntries(unsigned int from, unsigned int to)
+{
+    for (unsigned int i = from; i < to; i++)
+    {
+        JournalEntry* entry = &MonadJournal.entries[i];
+        if (entry->op == JOURNAL_REMOVE_MONAD && i < MonadJournal.done)
+            RemoveSubMonadsRecursive(entry->monad);
+    }
+    for (unsigned int i = to; i-- > from;)
+    {
+        JournalEntry* entry = &MonadJournal.entries[i];
+        if (entry->op == JOURNAL_ADD_MONAD && i >= MonadJournal.done)
+            RemoveSubMonadsRecursive(entry->monad);
+    }
+}
+
+JournalEntry* AppendJournalEntry(unsigned char op, MonadId monad)
+{
+    DropJournalEntries(MonadJournal.done, MonadJournal.count); //a new edit makes the undone ones unreachable.
+    MonadJournal.count = MonadJournal.done;
+
+    if (MonadJournal.count == MonadJournal.capacity)
+    {
+        if (MonadJournal.capacity >= JOURNAL_MAX_ENTRIES)
+        {
+            unsigned int cut = MonadJournal.count / 2;
+            while (cut < MonadJournal.count && !MonadJournal.entries[cut].stepStart)
+                cut++;
+            DropJournalEntries(0, cut);
+            memmove(MonadJournal.entries, MonadJournal.entries + cut, (MonadJournal.count - cut) * sizeof(JournalEntry));
+            MonadJournal.count -= cut;
+        }
+        else
+        {
+            MonadJournal.capacity = MonadJournal.capacity ? MonadJournal.capacity * 2 : 256;
+            MonadJournal.entries = realloc(MonadJournal.entries, MonadJournal.capacity * sizeof(JournalEntry));
+        }
+    }
+
+    JournalEntry* entry = &MonadJournal.entries[MonadJournal.count++];
+    *entry = (JournalEntry){ .op = op , .stepStart = MonadJournal.stepPending || MonadJournal.count == 1 , .monad = monad };
+    MonadJournal.done = MonadJournal.count;
+    MonadJournal.stepPending = false;
+    MonadJournal.sealed = op != JOURNAL_MOVE; //a rename is a whole edit already, see EndNameEdit.
+    return entry;
+}
+
+// Records the object where it sits in its container, before a removal or after an addition.
+void RecordMonadEntry(unsigned char op, MonadId monad)
+{
+    if (!JournalKeeps())
+        return;
+    MonadId containingMonad = MONAD(monad, container);
+    JournalEntry* entry = AppendJournalEntry(op, monad);
+    entry->container = containingMonad;
+    entry->mate = MONAD(monad, prev) != monad ? MONAD(monad, prev) : 0;
+    entry->wasRoot = MONAD(containingMonad, rootSubMonads) == monad;
+    entry->swap.position = MONAD(containingMonad, position);
+}
+
+// Records the link where it sits in its container, before a removal or after an addition.
+void RecordLinkEntry(unsigned char op, LinkId link)
+{
+    if (!JournalKeeps())
+        return;
+    Link* linkPtr = LINK(link);
+    JournalEntry* entry = AppendJournalEntry(op, linkPtr->startMonad);
+    entry->mate = linkPtr->endMonad;
+    entry->container = linkPtr->container;
+    entry->wasRoot = MONAD(linkPtr->container, rootSubLink) == link;
+    if (linkPtr->prev != link)
+    {
+        entry->swap.prevLink.start = LINK(linkPtr->prev)->startMonad;
+        entry->swap.prevLink.end = LINK(linkPtr->prev)->endMonad;
+    }
+}
+
+// Records the value a rename or move is about to overwrite. A run of moves on one object within one drag keeps only the first.
+JournalEntry* RecordChangeEntry(unsigned char op, MonadId monad)
+{
+    if (!JournalKeeps())
+        return NULL;
+    JournalEntry* last = MonadJournal.done ? &MonadJournal.entries[MonadJournal.done - 1] : NULL;
+    if (last && !MonadJournal.sealed && MonadJournal.done == MonadJournal.count && last->op == op && last->monad == monad)
+        return NULL;
+    return AppendJournalEntry(op, monad);
+}
+
+// Puts a cleared Monad beneath containingMonad as its newest sub-object and gives it the next default name. Accounting is left to the caller.
+void InsertSubMonad(MonadId newMonad, MonadId containingMonad)
+{
+    MONAD_W(newMonad, depth) = MONAD(containingMonad, depth) + 1;
+    MONAD_W(newMonad, arena) = MONAD(containingMonad, arena);
+    MONAD_W(newMonad, container) = containingMonad;
+    MONAD_W(containingMonad, subCount)++;
+
+    //insert new Monad in list entry.
+    MonadId root = MONAD(containingMonad, rootSubMonads);
+    if (root) //has entries.
+    {
+        MONAD_W(newMonad, name).text[0] = MonadNameText(root)[0] + 1;
+        MONAD_W(newMonad, next) = MONAD(root, next);
+        MONAD_W(newMonad, prev) = root;
+        MONAD_W(MONAD(root, next), prev) = newMonad;
+        MONAD_W(root, next) = newMonad;
+        MONAD_W(containingMonad, rootSubMonads) = newMonad;
+    }
+    else //after zero entries
+    {
+        MONAD_W(containingMonad, rootSubMonads) = newMonad;
+        MONAD_W(newMonad, next) = newMonad;
+        MONAD_W(newMonad, prev) = newMonad;
+        MONAD_W(newMonad, name).text[0] = 'A';
+    }
+}
+
+// Adds an object (subMonad) to containingMonad. containingMonad must not be null.
+MonadId AddMonad(Vector2 canvasPosition, MonadId containingMonad)
+{
+    //allocate and initialize new Monad. Always initialize variables that are not being overwritten.
+    MonadId newMonad = PoolAlloc(MonadPoolOf(MONAD(containingMonad, arena)));
+    ClearMonad(newMonad);
+    MONAD_W(newMonad, position) = canvasPosition;
+    InsertSubMonad(newMonad, containingMonad);
+    AccountSubtree(containingMonad, 1, 0);
+    RecordMonadEntry(JOURNAL_ADD_MONAD, newMonad);
+
+    //move containing Monad
+    MONAD_W(containingMonad, position) = Vector2Scale(Vector2Add(MONAD(containingMonad, position), canvasPosition), 0.5f);
+
+    return newMonad;
+}
+
+// Checks if two Monads are of the same category.
+bool SameCategory(MonadId monad, MonadId monadMate)
+{
+    return monadMate && MONAD(monad, container) == MONAD(monadMate, container);
+}
+
+// Puts the link on the ring of the Monad at the given end.
+void AttachLinkEnd(LinkId link, int end)
+{
+    Link* linkPtr = LINK_W(link);
+    MonadId monad = end == LINK_OUT ? linkPtr->startMonad : linkPtr->endMonad;
+    LinkId root = MONAD(monad, endLinks)[end];
+    if (root) //has entries.
+    {
+        Link* rootPtr = LINK_W(root);
+        linkPtr->nextAt[end] = rootPtr->nextAt[end];
+        linkPtr->prevAt[end] = root;
+        LINK_W(rootPtr->nextAt[end])->prevAt[end] = link;
+        rootPtr->nextAt[end] = link;
+    }
+    else //after zero entries
+    {
+        MONAD_W(monad, endLinks)[end] = link;
+        linkPtr->nextAt[end] = link;
+        linkPtr->prevAt[end] = link;
+    }
+}
+
+void DetachLinkEnd(LinkId link, int end)
+{
+    Link* linkPtr = LINK(link);
+    MonadId monad = end == LINK_OUT ? linkPtr->startMonad : linkPtr->endMonad;
+    if (linkPtr->nextAt[end] == link) //sole entry.
+        MONAD_W(monad, endLinks)[end] = 0;
+    else
+    {
+        if (MONAD(monad, endLinks)[end] == link)
+            MONAD_W(monad, endLinks)[end] = linkPtr->nextAt[end];
+        LINK_W(linkPtr->prevAt[end])->nextAt[end] = linkPtr->nextAt[end];
+        LINK_W(linkPtr->nextAt[end])->prevAt[end] = linkPtr->prevAt[end];
+    }
+}
+
+// Makes the link and puts it on every ring it belongs to, taking its node from alloc. Accounting is left to the caller.
+LinkId InsertLink(MonadId start, MonadId end, MonadId containingMonad, unsigned int (*alloc)(NodePool*))
+{
+    LinkId root = MONAD(containingMonad, rootSubLink);
+
+    //Return null if the combination already exists anywhere.
+    LinkPair* pair = ClaimLinkPair(start, end);
+    if (!pair)
+        return 0;
+
+    //allocate and initialize new Link. Always initialize variables that are not being overwritten.
+    LinkId newLink = alloc(LinkPoolOf(MONAD(containingMonad, arena)));
+    Link* newLinkPtr = LINK_W(newLink);
+    newLinkPtr->startMonad = start;
+    newLinkPtr->endMonad = end;
+    newLinkPtr->container = containingMonad;
+    pair->link = newLink;
+    AttachLinkEnd(newLink, LINK_OUT);
+    AttachLinkEnd(newLink, LINK_IN);
+
+    //insert new Link in list entry, behind the root so the ring reads in the order links were added.
+    if (root) //has entries.
+    {
+        Link* rootPtr = LINK_W(root);
+        newLinkPtr->next = root;
+        newLinkPtr->prev = rootPtr->prev;
+        LINK_W(rootPtr->prev)->next = newLink;
+        rootPtr->prev = newLink;
+    }
+    else //after zero entries
+    {
+        MONAD_W(containingMonad, rootSubLink) = newLink;
+        newLinkPtr->next = newLink;
+        newLinkPtr->prev = newLink;
+    }
+    return newLink;
+}
+
+// Add a link to containingMonad. start must be an object contained in the containingMonad. All parameters must not be null.
+LinkId AddLink(MonadId start, MonadId end, MonadId containingMonad)
+{
+    LinkId newLink = InsertLink(start, end, containingMonad, PoolAlloc);
+    if (newLink)
+    {
+        AccountSubtree(containingMonad, 0, 1);
+        RecordLinkEntry(JOURNAL_ADD_LINK, newLink);
+    }
+    return newLink;
+}
+
+// Builds count objects beneath containingMonad in one pass. parents[i] is the index of the object holding object i, or -1 for containingMonad, and must be lower than i.
+// names, positions and single names may be NULL. links holds linkCount (start, end) index pairs, each link is held by the container of its start.
+// Nodes come off fresh slots side by side, and the position of every container is worked out once at the end from its sub-objects.
+// handles receives the new Monad of every index. Returns false without adding anything if a parent index is out of range
+// or a link would join objects of different depths.
+bool BulkAddMonads(MonadId containingMonad, unsigned int count, const int parents[], const char* const names[], const Vector2 positions[],
+    const unsigned int links[][2], unsigned int linkCount, MonadId handles[])
+{
+    unsigned int* depths = malloc((count ? count : 1) * sizeof(unsigned int)); // beneath containingMonad, where each object will be placed.
+    bool valid = true;
+    for (unsigned int i = 0; i < count && valid; i++)
+    {
+        valid = parents[i] >= -1 && parents[i] < (int)i;
+        if (valid)
+            depths[i] = parents[i] < 0 ? 0 : depths[parents[i]] + 1;
+    }
+    for (unsigned int i = 0; i < linkCount && valid; i++)
+        valid = links[i][0] < count && links[i][1] < count && depths[links[i][0]] == depths[links[i][1]];
+    free(depths);
+    if (!valid)
+        return false;
+
+    Vector2 origin = MONAD(containingMonad, position);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        MonadId parent = parents[i] < 0 ? containingMonad : handles[parents[i]];
+        MonadId newMonad = PoolBump(MonadPoolOf(MONAD(parent, arena)));
+        ClearMonad(newMonad);
+        if (positions)
+            MONAD_W(newMonad, position) = positions[i];
+        else //spread out on a spiral around the container, so nothing sits on top of anything else.
+            MONAD_W(newMonad, position) = Vector2Add(origin, Vector2Rotate((Vector2){ 20.0f * sqrtf((float)i + 1.0f), 0.0f }, 2.39996f * i));
+        InsertSubMonad(newMonad, parent);
+        if (names && names[i])
+            SetMonadName(newMonad, names[i]);
+        RecordMonadEntry(JOURNAL_ADD_MONAD, newMonad);
+        handles[i] = newMonad;
+    }
+
+    unsigned int madeLinks = 0;
+    for (unsigned int i = 0; i < linkCount; i++)
+    {
+        MonadId start = handles[links[i][0]];
+        MonadId container = MONAD(start, container);
+        LinkId newLink = InsertLink(start, handles[links[i][1]], container, PoolBump);
+        if (!newLink)
+            continue;
+        RecordLinkEntry(JOURNAL_ADD_LINK, newLink);
+        madeLinks++;
+        if (container != containingMonad)
+            MONAD_W(container, subtreeLinks)++;
+    }
+
+    //children come after their parents, so walking backwards finishes every subtree before the object holding it.
+    Vector2* childSums = calloc(count ? count : 1, sizeof(Vector2));
+    Vector2 topSum = (Vector2){ 0 };
+    unsigned int topCount = 0;
+    for (unsigned int i = count; i-- > 0;)
+    {
+        MonadId monad = handles[i];
+        if (MONAD(monad, subCount))
+            MONAD_W(monad, position) = Vector2Scale(childSums[i], 1.0f / MONAD(monad, subCount));
+        MONAD_W(monad, peakBytes) = SubtreeBytes(monad);
+        if (parents[i] < 0)
+        {
+            topSum = Vector2Add(topSum, MONAD(monad, position));
+            topCount++;
+            continue;
+        }
+        MonadId parent = handles[parents[i]];
+        MONAD_W(parent, subtreeMonads) += MONAD(monad, subtreeMonads);
+        MONAD_W(parent, subtreeLinks) += MONAD(monad, subtreeLinks);
+        childSums[parents[i]] = Vector2Add(childSums[parents[i]], MONAD(monad, position));
+    }
+    free(childSums);
+
+    AccountSubtree(containingMonad, (int)count, (int)madeLinks);
+    if (topCount) //move containing Monad once, the way a single AddMonad would.
+        MONAD_W(containingMonad, position) = Vector2Scale(Vector2Add(origin, Vector2Scale(topSum, 1.0f / topCount)), 0.5f);
+    return true;
+}
+
+// Where each object of a subtree sits in a list built over it, kept for one operation in a table of its own rather than in the slabs.
+typedef struct MonadPlaces
+{
+    unsigned int** slabs; // place + 1 of each object by slab and slot, 0 for none. Only slabs holding a placed object get a block.
+    unsigned int slabCount;
+} MonadPlaces;
+
+MonadPlaces NewMonadPlaces(void)
+{
+    return (MonadPlaces){ calloc(MonadTable.slabCount, sizeof(unsigned int*)) , MonadTable.slabCount };
+}
+
+void FreeMonadPlaces(MonadPlaces* places)
+{
+    for (unsigned int i = 0; i < places->slabCount; i++)
+        free(places->slabs[i]);
+    free(places->slabs);
+    *places = (MonadPlaces){ 0 };
+}
+
+void SetMonadPlace(MonadPlaces* places, MonadId monad, unsigned int place)
+{
+    unsigned int slabIndex = monad >> SLAB_SHIFT;
+    if (slabIndex >= places->slabCount) //the table grew since the places were made.
+    {
+        places->slabs = realloc(places->slabs, MonadTable.slabCount * sizeof(unsigned int*));
+        memset(places->slabs + places->slabCount, 0, (MonadTable.slabCount - places->slabCount) * sizeof(unsigned int*));
+        places->slabCount = MonadTable.slabCount;
+    }
+    if (!places->slabs[slabIndex])
+        places->slabs[slabIndex] = calloc(SLAB_NODES, sizeof(unsigned int));
+    places->slabs[slabIndex][monad & SLAB_MASK] = place + 1;
+}
+
+// Place of the object, UINT_MAX if it was never placed.
+unsigned int MonadPlace(const MonadPlaces* places, MonadId monad)
+{
+    unsigned int slabIndex = monad >> SLAB_SHIFT;
+    if (slabIndex >= places->slabCount || !places->slabs[slabIndex])
+        return UINT_MAX;
+    return places->slabs[slabIndex][monad & SLAB_MASK] - 1;
+}
+
+// Places every object of the subtree by a walk before its sub-objects, starting from *count.
+void PlaceSubtreeRecursive(MonadPlaces* places, MonadId monad, unsigned int* count)
+{
+    SetMonadPlace(places, monad, (*count)++);
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            PlaceSubtreeRecursive(places, iterator, count);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+typedef struct MonadClone
+{
+    MonadId* order; // objects of the subtree being copied, each before its sub-objects, oldest sub-object first.
+    MonadId* clones; // the copy of each of them.
+    unsigned int count;
+    MonadPlaces places; // where each of them is in order.
+} MonadClone;
+
+void ListCloneOrderRecursive(MonadClone* clone, MonadId monad)
+{
+    SetMonadPlace(&clone->places, monad, clone->count);
+    clone->order[clone->count++] = monad;
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        rootMonad = MONAD(rootMonad, next); //Start at "index 0", root always points at last
+        MonadId iterator = rootMonad;
+        do
+        {
+            ListCloneOrderRecursive(clone, iterator);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// The copy of a Monad of the subtree being copied, 0 if the Monad is outside of it.
+MonadId ClonedMonad(const MonadClone* clone, MonadId monad)
+{
+    unsigned int place = MonadPlace(&clone->places, monad);
+    return place != UINT_MAX ? clone->clones[place] : 0;
+}
+
+// Copies an object, everything beneath it and every link between any of them beneath containingMonad, without going through text.
+// Names are kept and the whole copy is shifted so that the copy of monad sits at canvasPosition. Links reaching out of the subtree are left behind.
+// If containingMonad is 0 the copy is kept out of the tree in the global pools, and only FreeDetachedSubtree may free it.
+MonadId CloneMonad(MonadId monad, Vector2 canvasPosition, MonadId containingMonad)
+{
+    MonadClone clone = { 0 };
+    unsigned int capacity = MONAD(monad, subtreeMonads);
+    clone.order = malloc(capacity * sizeof(MonadId));
+    clone.clones = malloc(capacity * sizeof(MonadId));
+    clone.places = NewMonadPlaces();
+    ListCloneOrderRecursive(&clone, monad); //listed before anything is added, containingMonad may be beneath monad.
+    Vector2 offset = Vector2Subtract(canvasPosition, MONAD(monad, position));
+    for (unsigned int i = 0; i < clone.count; i++)
+    {
+        MonadId container = i ? ClonedMonad(&clone, MONAD(clone.order[i], container)) : containingMonad;
+        MonadId cloned = PoolBump(MonadPoolOf(container ? MONAD(container, arena) : 0));
+        ClearMonad(cloned);
+        MONAD_W(cloned, position) = Vector2Add(MONAD(clone.order[i], position), offset);
+        if (container)
+            InsertSubMonad(cloned, container);
+        if (containingMonad)
+            RecordMonadEntry(JOURNAL_ADD_MONAD, cloned);
+        MONAD_W(cloned, name) = MONAD(clone.order[i], name);
+        MONAD_W(cloned, subtreeMonads) = MONAD(clone.order[i], subtreeMonads);
+        clone.clones[i] = cloned;
+    }
+    MonadId newMonad = clone.clones[0];
+
+    //every object has its copy now, so links are copied in the order they were added, held by the copy of their container.
+    unsigned int madeLinks = 0;
+    for (unsigned int i = 0; i < clone.count; i++)
+    {
+        LinkId rootLink = MONAD(clone.order[i], rootSubLink);
+        if (!rootLink)
+            continue;
+        LinkId iterator = rootLink;
+        do
+        {
+            Link* iteratorPtr = LINK(iterator);
+            MonadId start = ClonedMonad(&clone, iteratorPtr->startMonad);
+            MonadId end = ClonedMonad(&clone, iteratorPtr->endMonad);
+            LinkId newLink = start && end ? InsertLink(start, end, clone.clones[i], PoolBump) : 0;
+            if (newLink)
+            {
+                if (containingMonad)
+                    RecordLinkEntry(JOURNAL_ADD_LINK, newLink);
+                MONAD_W(clone.clones[i], subtreeLinks)++;
+                madeLinks++;
+            }
+            iterator = iteratorPtr->next;
+        } while (iterator != rootLink);
+    }
+
+    //sub-objects come after the object holding them, so walking backwards finishes every subtree before its container.
+    for (unsigned int i = clone.count; i-- > 1;)
+    {
+        MonadId cloned = clone.clones[i];
+        MONAD_W(cloned, peakBytes) = SubtreeBytes(cloned);
+        MONAD_W(MONAD(cloned, container), subtreeLinks) += MONAD(cloned, subtreeLinks);
+    }
+    MONAD_W(newMonad, peakBytes) = SubtreeBytes(newMonad);
+    free(clone.order);
+    free(clone.clones);
+    FreeMonadPlaces(&clone.places);
+
+    if (containingMonad)
+    {
+        AccountSubtree(containingMonad, (int)clone.count, (int)madeLinks);
+        //move containing Monad, the way AddMonad does.
+        MONAD_W(containingMonad, position) = Vector2Scale(Vector2Add(MONAD(containingMonad, position), canvasPosition), 0.5f);
+    }
+    return newMonad;
+}
+
+// Frees the links held within a detached subtree, whose links only run between its own objects, so they go without unlinking each one.
+// Only their pairs are forgotten beneath an arena owned within the subtree, its slabs take the nodes along when it is released.
+void FreeHeldLinksRecursive(MonadId monad, bool freeNodes)
+{
+    ArenaId arena = MONAD(monad, arena);
+    if (arena && ArenaOf(arena)->owner == monad)
+        freeNodes = false;
+    LinkId rootLink = MONAD(monad, rootSubLink);
+    if (rootLink)
+    {
+        LinkId iterator = rootLink;
+        do
+        {
+            LinkId nextLink = LINK(iterator)->next;
+            UnindexLinkPair(LINK(iterator)->startMonad, LINK(iterator)->endMonad);
+            if (freeNodes)
+                PoolFree(LinkPoolOf(arena), iterator);
+            iterator = nextLink;
+        } while (iterator != rootLink);
+    }
+
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            FreeHeldLinksRecursive(iterator, freeNodes);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// Frees an object out of the tree along with everything beneath it, such as a copy CloneMonad kept aside. No link may reach outside it.
+void FreeDetachedSubtree(MonadId monad)
+{
+    FreeHeldLinksRecursive(monad, true);
+    RemoveSubMonadsRecursive(monad);
+}
+
+// Detached copy of the object last copied to the clipboard, and the text written for it.
+// Pasting clones the copy instead of reading the text back, as long as the clipboard still holds that text.
+// The copy is not part of the tree, so the memory overlay and dump report it on a line of its own. It is freed once the clipboard moves on.
+MonadId CopiedMonad = 0;
+char* CopiedText = NULL;
+
+// Remove a link from containingMonad. containingMonad must not be null. Fails if it is not the one holding the link.
+bool RemoveLink(LinkId link, MonadId containingMonad)
+{
+    if (!link || !MONAD(containingMonad, rootSubLink) || LINK(link)->container != containingMonad)
+        return false;
+
+    RecordLinkEntry(JOURNAL_REMOVE_LINK, link);
+    Link* linkPtr = LINK(link);
+    if (linkPtr->next == link) //is root and sole sub Link.
+        MONAD_W(containingMonad, rootSubLink) = 0;
+    else
+    {
+        if (MONAD(containingMonad, rootSubLink) == link) //is root and NOT sole sub Link.
+            MONAD_W(containingMonad, rootSubLink) = linkPtr->next;
+        LINK_W(linkPtr->prev)->next = linkPtr->next;
+        LINK_W(linkPtr->next)->prev = linkPtr->prev;
+    }
+    DetachLinkEnd(link, LINK_OUT);
+    DetachLinkEnd(link, LINK_IN);
+    UnindexLinkPair(linkPtr->startMonad, linkPtr->endMonad);
+    PoolFree(LinkPoolOf(MONAD(containingMonad, arena)), link);
+    AccountSubtree(containingMonad, 0, -1);
+    return true;
+}
+
+// Removes every link leaving or entering the Monad, wherever they are held. Costs the Monad's degree, not the links of the tree.
+void BreakMonadLinks(MonadId monad)
+{
+    for (int end = LINK_OUT; end <= LINK_IN; end++)
+    {
+        LinkId link;
+        while ((link = MONAD(monad, endLinks)[end]))
+            RemoveLink(link, LINK(link)->container);
+    }
+}
+
+// Breaks the links of the Monad and everything beneath it, so nothing outside is left pointing in once the subtree is freed.
+void BreakSubtreeLinksRecursive(MonadId monad)
+{
+    BreakMonadLinks(monad);
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            BreakSubtreeLinksRecursive(iterator);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// Links between the subtree and the rest of the tree, and those leaving it that are held outside it, gathered so they can be removed without walking rings that are changing.
+// members holds a place for every object of the subtree.
+void GatherCrossingLinksRecursive(MonadId monad, const MonadPlaces* members, LinkId** links, unsigned int* count, unsigned int* capacity)
+{
+    for (int end = LINK_OUT; end <= LINK_IN; end++)
+    {
+        LinkId rootLink = MONAD(monad, endLinks)[end];
+        if (!rootLink)
+            continue;
+        LinkId iterator = rootLink;
+        do
+        {
+            Link* iteratorPtr = LINK(iterator);
+            MonadId other = end == LINK_OUT ? iteratorPtr->endMonad : iteratorPtr->startMonad;
+            if (MonadPlace(members, other) == UINT_MAX || (end == LINK_OUT && MonadPlace(members, iteratorPtr->container) == UINT_MAX))
+            {
+                if (*count == *capacity)
+                {
+                    *capacity = *capacity ? *capacity * 2 : 16;
+                    *links = realloc(*links, *capacity * sizeof(LinkId));
+                }
+                (*links)[(*count)++] = iterator;
+            }
+            iterator = iteratorPtr->nextAt[end];
+        } while (iterator != rootLink);
+    }
+
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            GatherCrossingLinksRecursive(iterator, members, links, count, capacity);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// Takes the object and everything beneath it out of its container without freeing any of it. Its links must have been broken already.
+void DetachMonad(MonadId monad)
 {
-    char name[MAX_MONAD_NAME_SIZE];
-    Vector2 position;
-    struct Monad* rootSubMonads;
-    struct Monad* next;
-    struct Link* rootSubLink;
-    char deleteFrame;
-}  Monad;
+    MonadId containingMonad = MONAD(monad, container);
+    MonadId prev = MONAD(monad, prev);
+    MonadId next = MONAD(monad, next);
+    if (next == monad) //is root and sole sub Monad.
+        MONAD_W(containingMonad, rootSubMonads) = 0;
+    else
+    {
+        if (MONAD(containingMonad, rootSubMonads) == monad) //is root and NOT sole sub Monad, the last inserted of the rest takes over.
+            MONAD_W(containingMonad, rootSubMonads) = prev;
+        MONAD_W(prev, next) = next;
+        MONAD_W(next, prev) = prev;
+    }
+    MONAD_W(monad, next) = monad;
+    MONAD_W(monad, prev) = monad;
+    MONAD_W(containingMonad, subCount)--;
+    AccountSubtree(containingMonad, -(int)MONAD(monad, subtreeMonads), -(int)MONAD(monad, subtreeLinks));
+}
 
-typedef struct Link
+// Puts a detached object back into its container right after prev, or alone if prev is 0. wasRoot makes it the newest sub-object again.
+void AttachMonad(MonadId monad, MonadId prev, bool wasRoot)
 {
-    struct Monad* startMonad;
-    struct Monad* endMonad;
-    struct Link* next;
-} Link;
+    MonadId containingMonad = MONAD(monad, container);
+    if (prev)
+    {
+        MonadId next = MONAD(prev, next);
+        MONAD_W(monad, next) = next;
+        MONAD_W(monad, prev) = prev;
+        MONAD_W(next, prev) = monad;
+        MONAD_W(prev, next) = monad;
+    }
+    if (!prev || wasRoot)
+        MONAD_W(containingMonad, rootSubMonads) = monad;
+    MONAD_W(containingMonad, subCount)++;
+    AccountSubtree(containingMonad, (int)MONAD(monad, subtreeMonads), (int)MONAD(monad, subtreeLinks));
+}
 
-enum Response
+// Remove an object (subMonad), everything beneath it and every link touching any of them in one call. containingMonad must not be null.
+// While the journal records, the object is only taken out of the tree so it can be put back.
+bool RemoveMonad(MonadId monad, MonadId containingMonad)
 {
-    RESULT_NONE,
-    RESULT_CLICK,
-    RESULT_RCLICK
-};
+    if (MONAD(monad, container) != containingMonad)
+        return false;
+
+    //links are broken while still attached, so they are accounted for up the whole chain.
+    if (JournalKeeps()) //the journal only keeps objects without links, each one is recorded as it is broken.
+        BreakSubtreeLinksRecursive(monad);
+    else if (MONAD(monad, subtreeMonads) == 1) //nothing within it to keep links for.
+        BreakMonadLinks(monad);
+    else //only those the rest of the tree can reach, the ones within go along with the subtree.
+    {
+        LinkId* outerLinks = NULL;
+        unsigned int outerCount = 0;
+        unsigned int outerCapacity = 0;
+        MonadPlaces members = NewMonadPlaces();
+        unsigned int memberCount = 0;
+        PlaceSubtreeRecursive(&members, monad, &memberCount);
+        GatherCrossingLinksRecursive(monad, &members, &outerLinks, &outerCount, &outerCapacity);
+        FreeMonadPlaces(&members);
+        for (unsigned int i = 0; i < outerCount; i++)
+            RemoveLink(outerLinks[i], LINK(outerLinks[i])->container);
+        free(outerLinks);
+    }
+    RecordMonadEntry(JOURNAL_REMOVE_MONAD, monad);
+    DetachMonad(monad);
+    if (!JournalKeeps())
+        FreeDetachedSubtree(monad);
+    return true;
+}
 
-// After returning recursively up the chain, certain results can override other results depending on the situation.
-typedef struct ActiveResult
+// Renames the object the way an edit by hand does, so it can be undone.
+void RenameMonad(MonadId monad, const char* text)
 {
-    struct Monad* resultMonad;
-    struct Monad* resultContainerMonad;
-    struct Link* resultLink;
-    unsigned int resultDepth;
-    char resultKey;
-} ActiveResult;
-
-#define SCREENMARGIN 50
+    JournalEntry* entry = RecordChangeEntry(JOURNAL_RENAME, monad);
+    if (entry)
+        entry->swap.name = MONAD(monad, name);
+    SetMonadName(monad, text);
+}
 
-bool IsVector2OnScreen(Vector2 pos)
+// Ends the edit of the typed name, renaming its object once with the finished name.
+void EndNameEdit(void)
 {
-    return pos.x >= SCREENMARGIN && pos.x <= GetScreenWidth() - SCREENMARGIN && pos.y >= SCREENMARGIN && pos.y <= GetScreenHeight() - SCREENMARGIN;
+    MonadId monad = TypedName.monad;
+    if (!monad)
+        return;
+    TypedName.monad = 0;
+    if (strcmp(MonadNameText(monad), TypedName.text))
+        RenameMonad(monad, TypedName.text);
 }
 
-// Adds an object (subMonad) to ContainingMonadPtr. ContainingMonadPtr must not be null.
-struct Monad* AddMonad(Vector2 canvasPosition, Monad* containingMonadPtr)
+// Starts typing over the name of monad unless it is already being typed, ending the edit of any other object first.
+void BeginNameEdit(MonadId monad)
 {
-    //malloc and initialize new Monad. Always initialize variables that are not being overwritten.
-    Monad* newMonadPtr = (Monad*)malloc(sizeof(Monad));
-    memset(newMonadPtr, 0, sizeof(Monad));
-
-    newMonadPtr->position = canvasPosition;
-    newMonadPtr->rootSubMonads = NULL;
-    newMonadPtr->rootSubLink = NULL;
-    newMonadPtr->deleteFrame = DELETE_OFF;
-    newMonadPtr->name[1] = 0;
-
-    //insert new Monad in list entry.
-    Monad* rootPtr = containingMonadPtr->rootSubMonads;
-    if (rootPtr) //has entries.
+    if (TypedName.monad == monad)
+        return;
+    EndNameEdit();
+    const char* text = MonadNameText(monad);
+    unsigned int length = strlen(text);
+    if (length + 2 > TypedName.capacity) //room for one more character and the terminator.
     {
-        newMonadPtr->name[0] = containingMonadPtr->rootSubMonads->name[0] + 1;
-        newMonadPtr->next = rootPtr->next;
-        rootPtr->next = newMonadPtr;
-        containingMonadPtr->rootSubMonads = newMonadPtr;
+        TypedName.capacity = length + 2 > 64 ? (length + 2) * 2 : 64;
+        TypedName.text = realloc(TypedName.text, TypedName.capacity);
     }
-    else //after zero entries
+    memcpy(TypedName.text, text, length + 1);
+    TypedName.length = length;
+    TypedName.monad = monad;
+}
+
+// Adds a character to the end of the name typed into monad.
+void TypeNameChar(MonadId monad, char character)
+{
+    BeginNameEdit(monad);
+    if (TypedName.length + 2 > TypedName.capacity)
     {
-        containingMonadPtr->rootSubMonads = rootPtr = newMonadPtr;
-        rootPtr->next = newMonadPtr;
-        newMonadPtr->name[0] = 'A';
+        TypedName.capacity *= 2;
+        TypedName.text = realloc(TypedName.text, TypedName.capacity);
     }
+    TypedName.text[TypedName.length++] = character;
+    TypedName.text[TypedName.length] = '\0';
+}
 
-    //move containing Monad
-    containingMonadPtr->position = Vector2Scale(Vector2Add(containingMonadPtr->position, canvasPosition), 0.5f);
+// Takes the last character off the name typed into monad.
+void EraseNameChar(MonadId monad)
+{
+    BeginNameEdit(monad);
+    if (TypedName.length)
+        TypedName.text[--TypedName.length] = '\0';
+}
 
-    return newMonadPtr;
+void MoveMonad(MonadId monad, Vector2 position)
+{
+    if (Vector2Equals(MONAD(monad, position), position))
+        return;
+    JournalEntry* entry = RecordChangeEntry(JOURNAL_MOVE, monad);
+    if (entry)
+        entry->swap.position = MONAD(monad, position);
+    MONAD_W(monad, position) = position;
 }
 
-// Recursively frees the object and its links after calling the function for its sub-objects.
-void  RemoveSubMonadsRecursive(Monad* MonadPtr)
+// Whether monad is ancestor or beneath it. Costs the difference in their depths.
+bool IsBeneath(MonadId monad, MonadId ancestor)
 {
-    Monad* rootMonad = MonadPtr->rootSubMonads;
-    if (rootMonad)
+    for (MonadId iterator = monad; iterator && MONAD(iterator, depth) >= MONAD(ancestor, depth); iterator = MONAD(iterator, container))
     {
-        Monad* iterator = rootMonad;
-        do
-        {
-            Monad* nextMonad = iterator->next;
-            RemoveSubMonadsRecursive(iterator);
-            iterator = nextMonad;
-        } while (iterator != rootMonad);
+        if (iterator == ancestor)
+            return true;
     }
+    return false;
+}
 
-    Link* rootLink = MonadPtr->rootSubLink;
-    if (rootLink)
+void ShiftDepthsRecursive(MonadId monad, int depthDelta)
+{
+    MONAD_W(monad, depth) += depthDelta;
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
     {
-        Link* iterator = rootLink;
+        MonadId iterator = rootMonad;
         do
         {
-            Link* nextLink = iterator->next;
-            free(iterator);
-            iterator = nextLink;
-        } while (iterator != rootLink);
+            ShiftDepthsRecursive(iterator, depthDelta);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
     }
+}
 
-    free(MonadPtr);
+// Takes the object out of its container and puts it into containingMonad right after prev, or alone if prev is 0, the same way AttachMonad does.
+// Depths beneath it are only touched if containingMonad is at another depth. Links are left to the caller.
+void ShiftMonad(MonadId monad, MonadId containingMonad, MonadId prev, bool wasRoot)
+{
+    DetachMonad(monad);
+    int depthDelta = (int)(MONAD(containingMonad, depth) + 1) - (int)MONAD(monad, depth);
+    if (depthDelta)
+        ShiftDepthsRecursive(monad, depthDelta);
+    MONAD_W(monad, container) = containingMonad;
+    AttachMonad(monad, prev, wasRoot);
 }
 
-// Remove an object (subMonad) from containingMonadPtr. containingMonadPtr must not be null.
-bool RemoveMonad(Monad* MonadPtr, Monad* containingMonadPtr)
+// Moves an object and everything beneath it into containingMonad as its newest sub-object. No node is copied or moved in memory.
+// Into a container at the same depth this costs constant time plus the links leaving the object, which move over with it to stay held by its container.
+// Into another depth every depth beneath is shifted, and links between the subtree and the rest are broken since they would join different depths.
+// Fails if containingMonad is the object or beneath it, already holds it, or allocates from another arena than its container.
+bool ReparentMonad(MonadId monad, MonadId containingMonad)
 {
-    Monad* rootMonad = containingMonadPtr->rootSubMonads;
-    if (rootMonad)
+    MonadId oldContainer = MONAD(monad, container);
+    if (!oldContainer || oldContainer == containingMonad || IsBeneath(containingMonad, monad) || MONAD(containingMonad, arena) != MONAD(oldContainer, arena))
+        return false;
+
+    bool sameDepth = MONAD(containingMonad, depth) == MONAD(oldContainer, depth);
+    unsigned int linkCount = 0;
+    unsigned int linkCapacity = 0;
+    MonadId* linkEnds = NULL; // ends of the links leaving the object that its old container holds and that stay valid, moved over by their ends as link handles do not last.
+    LinkId rootLink = MONAD(monad, endLinks)[LINK_OUT];
+    if (rootLink)
     {
-        Monad* afterRoot = rootMonad->next;
-        Monad* prev = rootMonad;
-        Monad* iterator = afterRoot;
+        LinkId iterator = rootLink;
         do
         {
-            if (iterator == MonadPtr)
+            if (LINK(iterator)->container == oldContainer && (sameDepth || LINK(iterator)->endMonad == monad))
             {
-                if (rootMonad == rootMonad->next) //is root and sole sub Monad.
-                    containingMonadPtr->rootSubMonads = NULL;
-                else if (rootMonad == iterator) //is root and NOT sole sub Monad.
-                    containingMonadPtr->rootSubMonads = rootMonad->next;
-                prev->next = iterator->next;
-                RemoveSubMonadsRecursive(iterator);
-                return true;
+                if (linkCount == linkCapacity)
+                {
+                    linkCapacity = linkCapacity ? linkCapacity * 2 : 16;
+                    linkEnds = realloc(linkEnds, linkCapacity * sizeof(MonadId));
+                }
+                linkEnds[linkCount++] = LINK(iterator)->endMonad;
             }
-            prev = iterator;
-            iterator = iterator->next;
-        } while (iterator != afterRoot);
+            iterator = LINK(iterator)->nextAt[LINK_OUT];
+        } while (iterator != rootLink);
     }
-    return false;
-}
+    for (unsigned int i = 0; i < linkCount; i++)
+        RemoveLink(FindLinkPair(monad, linkEnds[i]), oldContainer);
 
-// Checks if two Monads are of the same category.
-bool SameCategory(Monad* MonadPtr, Monad* MonadMatePtr)
-{
-    Monad* iterator = MonadMatePtr;
-    if (iterator)
+    LinkId* crossingLinks = NULL; // links between the subtree and the rest, broken when the depth changes.
+    unsigned int crossingCount = 0;
+    unsigned int crossingCapacity = 0;
+    if (!sameDepth)
     {
-        do
-        {
-            if (iterator == MonadPtr)
-                return true;
-            iterator = iterator->next;
-        } while (iterator != MonadMatePtr);
+        MonadPlaces members = NewMonadPlaces();
+        unsigned int memberCount = 0;
+        PlaceSubtreeRecursive(&members, monad, &memberCount);
+        GatherCrossingLinksRecursive(monad, &members, &crossingLinks, &crossingCount, &crossingCapacity);
+        FreeMonadPlaces(&members);
     }
-    return false;
+    for (unsigned int i = 0; i < crossingCount; i++)
+        RemoveLink(crossingLinks[i], LINK(crossingLinks[i])->container);
+
+    RecordMonadEntry(JOURNAL_REPARENT, monad);
+    ShiftMonad(monad, containingMonad, MONAD(containingMonad, rootSubMonads), true);
+    for (unsigned int i = 0; i < linkCount; i++)
+        AddLink(monad, linkEnds[i], containingMonad);
+    free(linkEnds);
+    free(crossingLinks);
+    return true;
 }
 
-// Add a link to containingMonadPtr. start must be an object contained in the containingMonadPtr. All parameters must not be null.
-struct Link* AddLink(Monad* start, Monad* end, Monad* containingMonadPtr)
+// Moves a link from wherever it is in its container's ring to just after prev. wasRoot makes it the oldest link again.
+void MoveLinkAfter(LinkId link, LinkId prev, bool wasRoot)
 {
-    Link* rootPtr = containingMonadPtr->rootSubLink;
+    if (!prev || prev == link)
+        return;
+    Link* linkPtr = LINK_W(link);
+    MonadId containingMonad = linkPtr->container;
+    if (MONAD(containingMonad, rootSubLink) == link)
+        MONAD_W(containingMonad, rootSubLink) = linkPtr->next;
+    LINK_W(linkPtr->prev)->next = linkPtr->next;
+    LINK_W(linkPtr->next)->prev = linkPtr->prev;
+
+    LinkId next = LINK(prev)->next;
+    linkPtr->next = next;
+    linkPtr->prev = prev;
+    LINK_W(next)->prev = link;
+    LINK_W(prev)->next = link;
+    if (wasRoot)
+        MONAD_W(containingMonad, rootSubLink) = link;
+}
 
-    //Return existing link if it already exists.
-    if (rootPtr) //has entries.
+// Applies an entry backwards or forwards. Entries are only ever replayed in order, so everything around them is as it was when recorded.
+void ReplayJournalEntry(JournalEntry* entry, bool undo)
+{
+    switch (entry->op)
     {
-        Link* iterator = rootPtr;
-        do
+        case JOURNAL_ADD_MONAD:
+        case JOURNAL_REMOVE_MONAD:
         {
-            if ((iterator->startMonad == start) && (iterator->endMonad == end))
-                return NULL;
-            iterator = iterator->next;
-        } while (iterator != rootPtr);
-    }
-
-    //malloc and initialize new Link. Always initialize variables that are not being overwritten.
-    Link* newLinkPtr = (Link*)malloc(sizeof(Link));
-    newLinkPtr->startMonad = start;
-    newLinkPtr->endMonad = end;
-
-    //insert new Link in list entry.
-    if (rootPtr) //has entries.
-    {
-        Link* rootNextPtrUnchanged = rootPtr->next;
-        if (rootPtr == rootNextPtrUnchanged) //after one entry
+            if ((entry->op == JOURNAL_ADD_MONAD) == undo)
+                DetachMonad(entry->monad);
+            else
+                AttachMonad(entry->monad, entry->mate, entry->wasRoot);
+            if (entry->op == JOURNAL_ADD_MONAD) //adding moved the container.
+            {
+                Vector2 position = MONAD(entry->container, position);
+                MONAD_W(entry->container, position) = entry->swap.position;
+                entry->swap.position = position;
+            }
+            break;
+        }
+        case JOURNAL_ADD_LINK:
+        case JOURNAL_REMOVE_LINK:
         {
-            newLinkPtr->next = rootPtr;
-            rootPtr->next = newLinkPtr;
+            if ((entry->op == JOURNAL_ADD_LINK) == undo)
+                RemoveLink(FindLinkPair(entry->monad, entry->mate), entry->container);
+            else
+                MoveLinkAfter(AddLink(entry->monad, entry->mate, entry->container), FindLinkPair(entry->swap.prevLink.start, entry->swap.prevLink.end), entry->wasRoot);
+            break;
+        }
+        case JOURNAL_REPARENT:
+        {
+            MonadId containingMonad = MONAD(entry->monad, container);
+            MonadId prev = MONAD(entry->monad, prev) != entry->monad ? MONAD(entry->monad, prev) : 0;
+            bool wasRoot = MONAD(containingMonad, rootSubMonads) == entry->monad;
+            ShiftMonad(entry->monad, entry->container, entry->mate, entry->wasRoot);
+            entry->container = containingMonad;
+            entry->mate = prev;
+            entry->wasRoot = wasRoot;
+            break;
+        }
+        case JOURNAL_RENAME:
+        {
+            MonadName name = MONAD(entry->monad, name);
+            MONAD_W(entry->monad, name) = entry->swap.name;
+            entry->swap.name = name;
+            break;
         }
-        else //after two or more entries.
+        case JOURNAL_MOVE:
         {
-            newLinkPtr->next = rootNextPtrUnchanged;
-            rootPtr->next = newLinkPtr;
+            Vector2 position = MONAD(entry->monad, position);
+            MONAD_W(entry->monad, position) = entry->swap.position;
+            entry->swap.position = position;
+            break;
         }
     }
-    else //after zero entries
+}
+
+// Reverts the last step that is still done. Returns the number of entries undone, 0 if there was nothing to undo.
+unsigned int UndoJournalStep(void)
+{
+    unsigned int undone = 0;
+    MonadJournal.replaying = true;
+    while (MonadJournal.done)
     {
-        containingMonadPtr->rootSubLink = rootPtr = newLinkPtr;
-        rootPtr->next = newLinkPtr;
+        JournalEntry* entry = &MonadJournal.entries[--MonadJournal.done];
+        ReplayJournalEntry(entry, true);
+        undone++;
+        if (entry->stepStart)
+            break;
     }
-    return newLinkPtr;
+    MonadJournal.replaying = false;
+    MonadJournal.sealed = true;
+    return undone;
 }
 
-// Remove a link from containingMonadPtr. containingMonadPtr must not be null.
-bool RemoveLink(Link* linkPtr, Monad* containingMonadPtr)
+// Applies the first undone step again. Returns the number of entries redone, 0 if there was nothing to redo.
+unsigned int RedoJournalStep(void)
 {
-    Link* rootLink = containingMonadPtr->rootSubLink;
-    if (rootLink)
+    unsigned int redone = 0;
+    MonadJournal.replaying = true;
+    while (MonadJournal.done < MonadJournal.count && !(redone && MonadJournal.entries[MonadJournal.done].stepStart))
     {
-        Link* afterRoot = rootLink->next;
-        Link* prev = rootLink;
-        Link* iterator = afterRoot;
-        do
-        {
-            if (iterator == linkPtr)
-            {
-                if (rootLink == rootLink->next) //is root and sole sub Link.
-                    containingMonadPtr->rootSubLink = NULL;
-                else if (rootLink == iterator) //is root and NOT sole sub Link.
-                    containingMonadPtr->rootSubLink = rootLink->next;
-                prev->next = iterator->next;
-                free(iterator);
-                return true;
-            }
-            prev = iterator;
-            iterator = iterator->next;
-        } while (iterator != afterRoot);
+        ReplayJournalEntry(&MonadJournal.entries[MonadJournal.done++], false);
+        redone++;
     }
-    return false;
+    MonadJournal.replaying = false;
+    MonadJournal.sealed = true;
+    return redone;
 }
 
 //Draws dual beziers, and returns the midpoint.
@@ -309,85 +1828,62 @@ Vector2 DrawDualBeziers(Vector2 startV2 , Vector2 endV2 , Color colorCode , Colo
 #define INSCOPE functionDepth == selectedDepth
 #define PRESCOPE functionDepth < selectedDepth
 
-//Renders all Monads and Link. Returns activated Monad, it's container, if any and the depth. MonadPtr must not be null.
-struct ActiveResult* RecursiveDraw(Monad* MonadPtr, unsigned int functionDepth, unsigned int selectedDepth)
+//Renders the Monads and Links down to one level below selectedDepth, deeper levels are never visited. Returns activated Monad, it's container, if any and the depth. monad must not be null.
+struct ActiveResult* RecursiveDraw(MonadId monad, unsigned int functionDepth, unsigned int selectedDepth)
 {
     //check collision with mouse, generate first part of activeResult.
     ActiveResult activeResult = (ActiveResult){ 0 };
     activeResult.resultKey = (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) ? RESULT_CLICK : ((IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) ? RESULT_RCLICK : RESULT_NONE);
     activeResult.resultDepth = functionDepth;
-    if ((functionDepth >= selectedDepth) && CheckCollisionPointCircle(GetMousePosition(), MonadPtr->position, 30.0f))
-        activeResult.resultMonad = MonadPtr;
+    if ((functionDepth >= selectedDepth) && CheckCollisionPointCircle(GetMousePosition(), MONAD(monad, position), 30.0f))
+        activeResult.resultMonad = monad;
 
-    //iterate through the functors in the category.
-    Link* rootLinkPtr = MonadPtr->rootSubLink;
-    if (rootLinkPtr)
+    //iterate through the functors in the category, they are only drawn and hit at the selected depth.
+    LinkId rootLink = MONAD(monad, rootSubLink);
+    if (rootLink && INSCOPE)
     {
-        Link* iterator = rootLinkPtr;
+        LinkId iterator = rootLink;
         do
         {
-            if (INSCOPE)
+            Link* iteratorPtr = LINK(iterator);
+            Vector2 startV2 = MONAD(iteratorPtr->startMonad, position);
+            bool linkHit = false;
+            if (iteratorPtr->startMonad == iteratorPtr->endMonad)
             {
-                Vector2 startV2 = iterator->startMonad->position;
-                bool linkHit = false;
-                if (iterator->startMonad == iterator->endMonad)
-                {
-                    linkHit = CheckCollisionPointCircle(GetMousePosition(), Vector2Add(startV2, (Vector2) { 15.0f, 15.0f }), 30.0f);
-                    DrawRectangleV(startV2, (Vector2) { 10.0f, 10.0f }, (linkHit) ? RED : BLACK);
-                }
-                else
-                {
-                    float giantUpLerp = fmaxf(0.3f , fminf(350.0f , Vector2Distance(startV2 , GetMousePosition())) / 350.0f);
-                    Vector2 midPoint = DrawDualBeziers(startV2 , iterator->endMonad->position , BLUE , SameCategory(iterator->endMonad, iterator->startMonad) ? BLACK : RED , 2.0f/giantUpLerp , 1.0f/giantUpLerp);
-                    linkHit = CheckCollisionPointCircle(GetMousePosition() , midPoint , 30.0f);
-                    if (linkHit)
-                    {
-                        DrawLineBezier(startV2, midPoint, 2.2f, PURPLE);
-                    }
-                }
+                linkHit = CheckCollisionPointCircle(GetMousePosition(), Vector2Add(startV2, (Vector2) { 15.0f, 15.0f }), 30.0f);
+                DrawRectangleV(startV2, (Vector2) { 10.0f, 10.0f }, (linkHit) ? RED : BLACK);
+            }
+            else
+            {
+                float giantUpLerp = fmaxf(0.3f , fminf(350.0f , Vector2Distance(startV2 , GetMousePosition())) / 350.0f);
+                Vector2 midPoint = DrawDualBeziers(startV2 , MONAD(iteratorPtr->endMonad, position) , BLUE , SameCategory(iteratorPtr->endMonad, iteratorPtr->startMonad) ? BLACK : RED , 2.0f/giantUpLerp , 1.0f/giantUpLerp);
+                linkHit = CheckCollisionPointCircle(GetMousePosition() , midPoint , 30.0f);
                 if (linkHit)
                 {
-                    activeResult.resultLink = iterator;
-                    activeResult.resultMonad = MonadPtr;
+                    DrawLineBezier(startV2, midPoint, 2.2f, PURPLE);
                 }
             }
-
-            Link* nextSaved = iterator->next;
-            if ((iterator->startMonad->deleteFrame >= DELETE_POSTONLYLINK) || (iterator->endMonad->deleteFrame >= DELETE_POSTONLYLINK))
+            if (linkHit)
             {
-                if (RemoveLink(iterator, MonadPtr) && !(rootLinkPtr = MonadPtr->rootSubLink))
-                    break;
+                activeResult.resultLink = iterator;
+                activeResult.resultMonad = monad;
             }
-            iterator = nextSaved;
 
-        } while (iterator != rootLinkPtr);
+            iterator = iteratorPtr->next;
+        } while (iterator != rootLink);
     }
 
-    //iterate through the objects with this object treated as a category.
-    Monad* rootMonadPtr = MonadPtr->rootSubMonads;
+    //iterate through the objects with this object treated as a category. Nothing below the sub scope is drawn or hit, so the walk stops there.
+    MonadId rootMonad = (PRESCOPE || INSCOPE) ? MONAD(monad, rootSubMonads) : 0;
     float domainRadius = 5.0f;
-    if (rootMonadPtr)
+    if (rootMonad)
     {
-        Monad* iterator = rootMonadPtr;
+        MonadId iterator = rootMonad;
         do
         {
-            Monad* next = iterator->next;
-            if (iterator->deleteFrame >= DELETE_FINAL)
-            {
-                if (RemoveMonad(iterator, MonadPtr) && !(rootMonadPtr = MonadPtr->rootSubMonads))
-                {
-                    break;
-                }
-                else
-                {
-                    DrawLineV(MonadPtr->position, iterator->position, RED); // something went wrong if still shows.
-                }
-                iterator = next;
-                continue;
-            }
-            else if (INSCOPE)
+            if (INSCOPE)
             {
-                DrawLineV(MonadPtr->position, iterator->position, VIOLET);
+                DrawLineV(MONAD(monad, position), MONAD(iterator, position), VIOLET);
             }
 
             //--------------------------------
@@ -402,28 +1898,17 @@ struct ActiveResult* RecursiveDraw(Monad* MonadPtr, unsigned int functionDepth,
                 else if (activeOverrideMallocPtr->resultLink)
                 {
                     activeResult.resultLink = activeOverrideMallocPtr->resultLink;
-                    activeResult.resultMonad = MonadPtr;
+                    activeResult.resultMonad = monad;
                 }
                 free(activeOverrideMallocPtr);
             }
-            float newdomainRadius = Vector2Distance(MonadPtr->position , iterator->position);
+            float newdomainRadius = Vector2Distance(MONAD(monad, position) , MONAD(iterator, position));
             if (newdomainRadius > domainRadius)
             {
                 domainRadius = newdomainRadius;
             }
-            iterator = next;
-        } while (iterator != rootMonadPtr);
-    }
-
-    //mark for deletion progression
-    if (MonadPtr->deleteFrame >= DELETE_PRELINK)
-    {
-        MonadPtr->deleteFrame++;
-        return NULL;
-    }
-    else if (MonadPtr->deleteFrame >= DELETE_POSTONLYLINK)
-    {
-        MonadPtr->deleteFrame--;
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
     }
 
     //cancel any more drawing.
@@ -431,254 +1916,433 @@ struct ActiveResult* RecursiveDraw(Monad* MonadPtr, unsigned int functionDepth,
         return NULL;
 
     //we have returned back to the container, since this is null, we know that this is the container.
-    if (!activeResult.resultContainerMonad && (activeResult.resultMonad != MonadPtr))
-        activeResult.resultContainerMonad = MonadPtr;
+    if (!activeResult.resultContainerMonad && (activeResult.resultMonad != monad))
+        activeResult.resultContainerMonad = monad;
 
     if (INSCOPE)
     {
-        DrawPoly(MonadPtr->position, 3, 5.0f, 0, PURPLE);
-        DrawText(MonadPtr->name, (int)MonadPtr->position.x + 10, (int)MonadPtr->position.y + 10, 24, Fade(PURPLE, 0.5f));
+        DrawPoly(MONAD(monad, position), 3, 5.0f, 0, PURPLE);
+        DrawText(MonadNameText(monad), (int)MONAD(monad, position).x + 10, (int)MONAD(monad, position).y + 10, 24, Fade(PURPLE, 0.5f));
     }
     else if (PRESCOPE)
     {
-        DrawCircleLinesV(MonadPtr->position, domainRadius , Fade(GRAY, (float)functionDepth / (float)selectedDepth));
+        DrawCircleLinesV(MONAD(monad, position), domainRadius , Fade(GRAY, (float)functionDepth / (float)selectedDepth));
     }
     else if (SUBSCOPE)
     {
-        DrawCircleV(MonadPtr->position, 5.0f, BLUE);
-        DrawText(MonadPtr->name, (int)MonadPtr->position.x + 10, (int)MonadPtr->position.y + 10, 16, Fade(SKYBLUE, 0.5f));
+        DrawCircleV(MONAD(monad, position), 5.0f, BLUE);
+        DrawText(MonadNameText(monad), (int)MONAD(monad, position).x + 10, (int)MONAD(monad, position).y + 10, 16, Fade(SKYBLUE, 0.5f));
     }
 
-    if (activeResult.resultMonad == MonadPtr)
-        DrawCircleLinesV(MonadPtr->position, 20.0f, ORANGE);
+    if (activeResult.resultMonad == monad)
+        DrawCircleLinesV(MONAD(monad, position), 20.0f, ORANGE);
 
     return memcpy(malloc(sizeof(ActiveResult)) , &activeResult , sizeof(ActiveResult));
 }
 
-enum discardAppend
+// Text written in place, at least doubling its capacity whenever it runs out, so appending costs amortized constant time per character.
+typedef struct TextBuilder
 {
-    DISCARD_NONE, // Neither are malloc'd.
-    DISCARD_FIRST, // Use when str2 is not a malloc'd char array.
-    DISCARD_BOTH // Both are malloc'd.
-};
+    char* text; // zero terminated once anything has been appended.
+    size_t length;
+    size_t capacity;
+} TextBuilder;
 
-char* AppendMallocDiscard(char* str1, char* str2, char discardLevel)
+// Makes room for extra more characters after the current ones, along with the terminator.
+void GrowText(TextBuilder* out, size_t extra)
 {
-    char* new_str = NULL;
-    if ((new_str = malloc(strlen(str1)+strlen(str2)+1)))
-    {
-        new_str[0] = '\0';
-        strcat(new_str,str1);
-        strcat(new_str,str2);
-    }
+    if (out->length + extra < out->capacity)
+        return;
+    size_t capacity = out->capacity ? out->capacity * 2 : 256;
+    while (capacity <= out->length + extra)
+        capacity *= 2;
+    out->text = realloc(out->text, capacity);
+    out->capacity = capacity;
+}
+
+void AppendText(TextBuilder* out, const char* text, size_t length)
+{
+    GrowText(out, length);
+    memcpy(out->text + out->length, text, length);
+    out->length += length;
+    out->text[out->length] = '\0';
+}
+
+void AppendChar(TextBuilder* out, char character)
+{
+    GrowText(out, 1);
+    out->text[out->length++] = character;
+    out->text[out->length] = '\0';
+}
+
+#define _FORBIDDEN "[]:;?>\0\r\n"
+#define _HIGHESTCHAR 255
 
-    if (discardLevel >= DISCARD_FIRST)
+// The character a base-255 digit of an ID is written as. Digits landing on a forbidden character are pushed past it, which makes a few of them collide.
+char IDCharacter(unsigned int digit)
+{
+    char character = (char)digit;
+    const char* iteratorForbidden = _FORBIDDEN;
+    while (iteratorForbidden[0] != '\0')
     {
-        if(str1)
+        if (character == iteratorForbidden[0])
         {
-            free(str1);
+            character++;
         }
-        if(discardLevel >= DISCARD_BOTH && str2)
+        else
         {
-            free(str2);
+            iteratorForbidden++;
         }
     }
-
-    return new_str;
+    return character;
 }
 
-#define _FORBIDDEN "[]:;?>\0\r\n"
-
-char* GenerateIDMalloc(unsigned int index) //sub monads limited by the highest int, really high.
+// Writes a sibling ordinal as an ID, one base-255 digit per character, lowest first.
+void AppendID(TextBuilder* out, unsigned int index) //sub monads limited by the highest int, really high.
 {
     index++;//so it isn't 0
-    char* forbiddenChars = _FORBIDDEN;
-    char* ret = malloc(1);
-    ret[0] = '\0';
-    #define _HIGHESTCHAR 255
     for (; index; index /= _HIGHESTCHAR)
     {
-        char character[2] = {(char)(index % _HIGHESTCHAR) , '\0'};
-        char* iteratorForbidden = forbiddenChars;
-        while (iteratorForbidden[0] != '\0')
+        char character = IDCharacter(index % _HIGHESTCHAR);
+        if (character) //a zero digit would end the string, it has never been written.
+            AppendChar(out, character);
+    }
+}
+
+unsigned char IDDigits[256]; // digit each character of an ID stands for, the lowest where several collide, 0 for none.
+
+// Reads length characters of an ID back into the ordinal it was written for in one pass, UINT_MAX if nothing writes it.
+// Where IDs collide this is the lowest ordinal, the same one a search counting up from 0 would find first.
+// '?' marks a reversed link wherever it falls among the characters and is skipped.
+unsigned int DecodeID(const char* id, unsigned int length)
+{
+    if (!IDDigits[(unsigned char)IDCharacter(1)]) //first call.
+    {
+        for (unsigned int digit = _HIGHESTCHAR - 1; digit; digit--)
+            IDDigits[(unsigned char)IDCharacter(digit)] = digit;
+    }
+
+    unsigned long long value = 0;
+    unsigned long long scale = 1;
+    for (unsigned int i = 0; i < length; i++)
+    {
+        if (id[i] == '?')
+            continue;
+        unsigned char digit = IDDigits[(unsigned char)id[i]];
+        if (!digit)
+            return UINT_MAX;
+        value += digit * scale;
+        if (value > UINT_MAX)
+            return UINT_MAX;
+        scale *= _HIGHESTCHAR;
+    }
+    return value ? (unsigned int)(value - 1) : UINT_MAX;
+}
+
+// Writes a name with every character the text format uses for itself turned into '_'.
+void AppendPrunedName(TextBuilder* out, const char* name)
+{
+    size_t length = strlen(name);
+    GrowText(out, length);
+    for (size_t i = 0; i < length; i++)
+        out->text[out->length + i] = strchr(_FORBIDDEN, name[i]) ? '_' : name[i];
+    out->length += length;
+    out->text[out->length] = '\0';
+}
+
+// Euler tour of a subtree with a sparse table over blocks of it, so the shallowest object between two visits is found in constant time.
+// Built once per serialization, every interlink's shared object is then the common ancestor of two containers.
+#define ANCESTOR_BLOCK 32
+
+typedef struct AncestorIndex
+{
+    MonadId root;
+    MonadId* tour; // every object, listed again after each of its sub-objects.
+    unsigned int* tourDepth;
+    unsigned int tourLength;
+    unsigned int** blockMin; // blockMin[level][block] is the tour index of the shallowest entry in blocks block to block + 2^level - 1.
+    unsigned int levelCount;
+    MonadPlaces firstVisits; // tour index where each object is first listed.
+} AncestorIndex;
+
+void TourAncestorsRecursive(AncestorIndex* index, MonadId monad)
+{
+    SetMonadPlace(&index->firstVisits, monad, index->tourLength);
+    index->tourDepth[index->tourLength] = MONAD(monad, depth);
+    index->tour[index->tourLength++] = monad;
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
         {
-            if (character[0] == iteratorForbidden[0])
-            {
-                character[0]++;
-            }
-            else
-            {
-                iteratorForbidden++;
-            }
-        }
-        ret = AppendMallocDiscard(ret , character , DISCARD_FIRST);
+            TourAncestorsRecursive(index, iterator);
+            index->tourDepth[index->tourLength] = MONAD(monad, depth);
+            index->tour[index->tourLength++] = monad;
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
     }
-    return ret;
 }
 
-char* PruneForbiddenCharactersMalloc(char* name)
+AncestorIndex BuildAncestorIndex(MonadId root)
 {
-    char* newName = malloc(strlen(name) + 1);
-    char* forbiddenChars = _FORBIDDEN;
-    int index = 0;
-    while (name[index] != '\0')
+    AncestorIndex index = { .root = root };
+    unsigned int capacity = MONAD(root, subtreeMonads) * 2;
+    index.tour = malloc(capacity * sizeof(MonadId));
+    index.tourDepth = malloc(capacity * sizeof(unsigned int));
+    index.firstVisits = NewMonadPlaces();
+    TourAncestorsRecursive(&index, root);
+
+    unsigned int blockCount = (index.tourLength + ANCESTOR_BLOCK - 1) / ANCESTOR_BLOCK;
+    while ((1u << index.levelCount) <= blockCount)
+        index.levelCount++;
+    index.blockMin = malloc(index.levelCount * sizeof(unsigned int*));
+    index.blockMin[0] = malloc(blockCount * sizeof(unsigned int));
+    for (unsigned int i = 0; i < index.tourLength; i++)
+    {
+        unsigned int* best = &index.blockMin[0][i / ANCESTOR_BLOCK];
+        if (i % ANCESTOR_BLOCK == 0 || index.tourDepth[i] < index.tourDepth[*best])
+            *best = i;
+    }
+    for (unsigned int level = 1; level < index.levelCount; level++)
     {
-        char* editedCharacter = &newName[index];
-        char* iteratorForbidden = forbiddenChars;
-        *editedCharacter = name[index];
-        while (iteratorForbidden[0] != '\0')
+        unsigned int span = 1u << (level - 1);
+        index.blockMin[level] = malloc((blockCount - (span * 2) + 1) * sizeof(unsigned int));
+        for (unsigned int block = 0; block + span * 2 <= blockCount; block++)
         {
-            if (*editedCharacter == iteratorForbidden[0])
-            {
-                *editedCharacter = '_';
-                break;
-            }
-            iteratorForbidden++;
+            unsigned int left = index.blockMin[level - 1][block];
+            unsigned int right = index.blockMin[level - 1][block + span];
+            index.blockMin[level][block] = index.tourDepth[right] < index.tourDepth[left] ? right : left;
         }
-        index++;
     }
-    newName[index] = '\0';
-    return newName;
+    return index;
 }
 
-//Finds interlinks.
-typedef struct DepthResult
+void FreeAncestorIndex(AncestorIndex* index)
 {
-    Monad* containerMonad;
-    Monad* sharedMonad; //highest point where both container and cousin can be both traced to.
-    unsigned int depth;
-    unsigned int sharedDepth;
-} DepthResult;
-DepthResult FindDepthOfObject(Monad* selectedMonad , Monad* findMonad , Monad* findCousinMonad , unsigned int Depth)
+    for (unsigned int level = 0; level < index->levelCount; level++)
+        free(index->blockMin[level]);
+    free(index->blockMin);
+    free(index->tour);
+    free(index->tourDepth);
+    FreeMonadPlaces(&index->firstVisits);
+}
+
+bool IsInAncestorIndex(const AncestorIndex* index, MonadId monad)
+{
+    if (!monad)
+        return false;
+    return MonadPlace(&index->firstVisits, monad) != UINT_MAX;
+}
+
+// Both Monads must be in the index.
+MonadId CommonAncestor(const AncestorIndex* index, MonadId monad, MonadId monadMate)
 {
-    if (selectedMonad == findMonad)
-        return (DepthResult){NULL , NULL , Depth , -1};
-    Monad* rootMonadPtr = selectedMonad->rootSubMonads;
-    if (rootMonadPtr)
+    unsigned int first = MonadPlace(&index->firstVisits, monad);
+    unsigned int last = MonadPlace(&index->firstVisits, monadMate);
+    if (first > last)
     {
-        Monad* iterator = rootMonadPtr;
-        do
+        unsigned int swap = first;
+        first = last;
+        last = swap;
+    }
+
+    unsigned int best = first;
+    unsigned int firstBlock = first / ANCESTOR_BLOCK;
+    unsigned int lastBlock = last / ANCESTOR_BLOCK;
+    unsigned int scanEnd = firstBlock == lastBlock ? last : firstBlock * ANCESTOR_BLOCK + ANCESTOR_BLOCK - 1;
+    for (unsigned int i = first; i <= scanEnd; i++)
+    {
+        if (index->tourDepth[i] < index->tourDepth[best])
+            best = i;
+    }
+    if (firstBlock != lastBlock)
+    {
+        for (unsigned int i = lastBlock * ANCESTOR_BLOCK; i <= last; i++)
         {
-            DepthResult result = FindDepthOfObject(iterator , findMonad , findCousinMonad , Depth + 1);
-            if (result.depth != -1)
-            {
-                if (!result.containerMonad)
-                    result.containerMonad = selectedMonad;
-                if (result.sharedDepth == -1 && findCousinMonad)
-                {
-                    Monad* iterator2 = rootMonadPtr;
-                    do
-                    {
-                        DepthResult cousinResult = FindDepthOfObject(iterator2 , findCousinMonad , NULL , Depth + 1);
-                        if (cousinResult.depth != -1) // If it's found, simply
-                        {
-                            result.sharedMonad = selectedMonad;
-                            result.sharedDepth = Depth;
-                            break;
-                        }
-                        iterator2 = iterator2->next;
-                    } while (iterator2 != rootMonadPtr);
-                }
-                return result;
-            }
-            iterator = iterator->next;
-        } while (iterator != rootMonadPtr);
+            if (index->tourDepth[i] < index->tourDepth[best])
+                best = i;
+        }
+        if (firstBlock + 1 < lastBlock) //whole blocks in between, two overlapping spans cover them.
+        {
+            unsigned int blockCount = lastBlock - firstBlock - 1;
+            unsigned int level = 0;
+            while ((2u << level) <= blockCount)
+                level++;
+            unsigned int left = index->blockMin[level][firstBlock + 1];
+            unsigned int right = index->blockMin[level][lastBlock - (1u << level)];
+            if (index->tourDepth[left] < index->tourDepth[best])
+                best = left;
+            if (index->tourDepth[right] < index->tourDepth[best])
+                best = right;
+        }
     }
-    return (DepthResult){NULL , NULL , -1 , -1};
+    return index->tour[best];
 }
 
-char* ChainCarrotAfterJumpStringRecursiveMalloc(Monad* sharedMonad , Monad* endMonad)
+// Sub-objects of every object in a subtree laid out side by side, oldest first, so the sibling ordinals of the text format resolve both ways in constant time.
+// Like AncestorIndex it is built for one serialization or paste and only holds while the subtree is left unchanged.
+typedef struct SiblingIndex
 {
-    Monad* matchingIterator = sharedMonad->rootSubMonads;
-    char* ret = AppendMallocDiscard("","",DISCARD_NONE); // must malloc.
-    if (matchingIterator)
+    MonadId root;
+    MonadId* order;
+    unsigned int orderLength;
+    MonadPlaces ordinals; // place of each object among its siblings, oldest first. The root has none.
+    MonadPlaces firstSubs; // where the sub-objects of each object start in order.
+} SiblingIndex;
+
+void IndexSiblingsRecursive(SiblingIndex* index, MonadId monad)
+{
+    SetMonadPlace(&index->firstSubs, monad, index->orderLength);
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
     {
-        unsigned int index = 0;
+        rootMonad = MONAD(rootMonad, next); //Start at "index 0", root always points at last
+        MonadId iterator = rootMonad;
+        unsigned int ordinal = 0;
         do
         {
-            if (matchingIterator == endMonad)
-            {
-                ret = AppendMallocDiscard(ret , ">", DISCARD_FIRST);
-                return AppendMallocDiscard(ret , GenerateIDMalloc(index) , DISCARD_BOTH);
-            }
-            char* test = AppendMallocDiscard(ChainCarrotAfterJumpStringRecursiveMalloc(matchingIterator , endMonad) , "" , DISCARD_FIRST);
-            if (test[0] != '\0') //mom get the camera.
-            {
-                ret = AppendMallocDiscard(ret , ">" , DISCARD_FIRST);
-                ret = AppendMallocDiscard(ret , GenerateIDMalloc(index) , DISCARD_BOTH);
-                return AppendMallocDiscard(ret , test , DISCARD_BOTH);
-            }
-            free(test);
-            index++;
-            matchingIterator = matchingIterator->next;
-        } while (matchingIterator != sharedMonad->rootSubMonads);
+            SetMonadPlace(&index->ordinals, iterator, ordinal++);
+            index->order[index->orderLength++] = iterator;
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+        do
+        {
+            IndexSiblingsRecursive(index, iterator);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
     }
-    return ret;
 }
 
-//TODO this is printing out monads out in the wrong order.
-void PrintMonadsRecursive(Monad* MonadPtr, Monad* OriginalMonad, char** outRef)
+SiblingIndex BuildSiblingIndex(MonadId root)
+{
+    SiblingIndex index = { .root = root };
+    index.order = malloc(MONAD(root, subtreeMonads) * sizeof(MonadId));
+    index.ordinals = NewMonadPlaces();
+    index.firstSubs = NewMonadPlaces();
+    IndexSiblingsRecursive(&index, root);
+    return index;
+}
+
+void FreeSiblingIndex(SiblingIndex* index)
+{
+    free(index->order);
+    FreeMonadPlaces(&index->ordinals);
+    FreeMonadPlaces(&index->firstSubs);
+}
+
+// Place of the object among its siblings, oldest first. monad must be beneath the root of the index.
+unsigned int SiblingOrdinal(const SiblingIndex* index, MonadId monad)
+{
+    return MonadPlace(&index->ordinals, monad);
+}
+
+// The sub-object at ordinal inside monad, null if there are not that many. monad must be in the index.
+MonadId SubMonadAt(const SiblingIndex* index, MonadId monad, unsigned int ordinal)
+{
+    if (ordinal >= MONAD(monad, subCount))
+        return 0;
+    return index->order[MonadPlace(&index->firstSubs, monad) + ordinal];
+}
+
+// Resolves a sub-object written as an ordinal, falling back to the first one like a walk that finds nothing.
+MonadId SubMonadOrFirst(const SiblingIndex* index, MonadId monad, unsigned int ordinal)
+{
+    MonadId subMonad = SubMonadAt(index, monad, ordinal);
+    return subMonad ? subMonad : SubMonadAt(index, monad, 0);
+}
+
+//Finds interlinks.
+typedef struct DepthResult
+{
+    MonadId containerMonad;
+    MonadId sharedMonad; //highest point where both container and cousin can be both traced to.
+    unsigned int depth;
+    unsigned int sharedDepth;
+} DepthResult;
+DepthResult FindDepthOfObject(const AncestorIndex* index , MonadId findMonad , MonadId findCousinMonad)
+{
+    if (!IsInAncestorIndex(index, findMonad))
+        return (DepthResult){0 , 0 , -1 , -1};
+
+    unsigned int selectedDepth = MONAD(index->root, depth);
+    DepthResult result = (DepthResult){0 , 0 , MONAD(findMonad, depth) - selectedDepth , -1};
+    if (findMonad == index->root)
+        return result;
+    result.containerMonad = MONAD(findMonad, container);
+
+    //the deepest object both are strictly beneath is the common ancestor of their containers.
+    MonadId cousinContainer = findCousinMonad ? MONAD(findCousinMonad, container) : 0;
+    if (!IsInAncestorIndex(index, cousinContainer))
+        return result;
+    result.sharedMonad = CommonAncestor(index, result.containerMonad, cousinContainer);
+    result.sharedDepth = MONAD(result.sharedMonad, depth) - selectedDepth;
+    return result;
+}
+
+// Spells out the turns from sharedMonad down to monad, one sibling ordinal per level. monad must be beneath sharedMonad and in the SiblingIndex.
+void AppendTurnsRecursive(TextBuilder* out, const SiblingIndex* siblings, MonadId sharedMonad, MonadId monad)
+{
+    if (MONAD(monad, depth) <= MONAD(sharedMonad, depth))
+        return;
+    AppendTurnsRecursive(out, siblings, sharedMonad, MONAD(monad, container));
+    AppendChar(out, '>');
+    AppendID(out, SiblingOrdinal(siblings, monad));
+}
+
+// Sub-objects and links are written in the order they were added, sibling ordinals in links count the same way.
+void PrintMonadsRecursive(MonadId monad, const AncestorIndex* ancestors, const SiblingIndex* siblings, TextBuilder* out)
 {
-    char* out = *outRef;
-    out = AppendMallocDiscard(out , "[" , DISCARD_FIRST);
-    out = AppendMallocDiscard(out , PruneForbiddenCharactersMalloc(MonadPtr->name) , DISCARD_BOTH);
-    out = AppendMallocDiscard(out , ":" , DISCARD_FIRST);
+    AppendChar(out, '[');
+    AppendPrunedName(out, MonadNameText(monad));
+    AppendChar(out, ':');
 
-    *outRef = out; //reset this before the iteration.
     //iterate through the objects with this object treated as a category.
-    Monad* rootMonadPtr = MonadPtr->rootSubMonads;
-    if (rootMonadPtr)
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
     {
-        rootMonadPtr = rootMonadPtr->next; //Start at "index 0", root always points at last
-        Monad* iterator = rootMonadPtr;
+        rootMonad = MONAD(rootMonad, next); //Start at "index 0", root always points at last
+        MonadId iterator = rootMonad;
         do
         {
-            PrintMonadsRecursive(iterator , OriginalMonad , outRef);
-            iterator = iterator->next;
-        } while (iterator != rootMonadPtr);
-        out = *outRef; // Old reference is most certainly freed in recursive calls. Update.
+            PrintMonadsRecursive(iterator , ancestors , siblings , out);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
     }
 
-    out = AppendMallocDiscard(out , ":" , DISCARD_FIRST);
+    AppendChar(out, ':');
 
     //iterate through the functors in the category.
-    Link* rootLinkPtr = MonadPtr->rootSubLink;
-    if (rootLinkPtr && rootMonadPtr)
+    LinkId rootLink = MONAD(monad, rootSubLink);
+    if (rootLink && rootMonad)
     {
-        Link* iterator = rootLinkPtr;
+        LinkId iterator = rootLink;
         do
         {
-            DepthResult depthResult = FindDepthOfObject(OriginalMonad , iterator->startMonad , iterator->endMonad , 0);
+            Link* iteratorPtr = LINK(iterator);
+            DepthResult depthResult = FindDepthOfObject(ancestors , iteratorPtr->startMonad , iteratorPtr->endMonad);
             if (depthResult.sharedMonad)
             {
                 unsigned int jumpBy = depthResult.depth - depthResult.sharedDepth - 1;
-                unsigned int subIndex = 0;
-                Monad* matchingIterator = rootMonadPtr;
-                do
+                bool startFound = MONAD(iteratorPtr->startMonad, container) == monad;
+                if (startFound || (jumpBy && MONAD(iteratorPtr->endMonad, container) == monad))
                 {
-                    bool startFound = matchingIterator == iterator->startMonad;
-                    if (startFound || (jumpBy && matchingIterator == iterator->endMonad))
+                    MonadId subMonad = startFound ? iteratorPtr->startMonad : iteratorPtr->endMonad;
+                    AppendID(out, SiblingOrdinal(siblings, subMonad)); // Start monad index.
+                    AppendChar(out, '>');
+                    AppendID(out, jumpBy); //Must "jump up" by this amount.
+                    AppendTurnsRecursive(out, siblings, depthResult.sharedMonad, startFound ? iteratorPtr->endMonad : iteratorPtr->startMonad); // Make these turns.
+                    if (!startFound)
                     {
-                        out = AppendMallocDiscard(out , GenerateIDMalloc(subIndex) , DISCARD_BOTH); // Start monad index.
-                        out = AppendMallocDiscard(out , ">" , DISCARD_FIRST);
-                        out = AppendMallocDiscard(out , GenerateIDMalloc(jumpBy) , DISCARD_BOTH); //Must "jump up" by this amount.
-                        out = AppendMallocDiscard(out , ChainCarrotAfterJumpStringRecursiveMalloc(depthResult.sharedMonad , startFound ? iterator->endMonad : iterator->startMonad), DISCARD_BOTH); // Make these turns.
-                        if (!startFound)
-                        {
-                            out = AppendMallocDiscard(out , "?" , DISCARD_FIRST);
-                        }
-                        out = AppendMallocDiscard(out , ";" , DISCARD_FIRST);
-                        break;
+                        AppendChar(out, '?');
                     }
-                    matchingIterator = matchingIterator->next;
-                    subIndex++;
-                } while (matchingIterator != rootMonadPtr);
+                    AppendChar(out, ';');
+                }
             }
-            iterator = iterator->next;
-        } while (iterator != rootLinkPtr);
+            iterator = iteratorPtr->next;
+        } while (iterator != rootLink);
     }
-    out = AppendMallocDiscard(out , "]" , DISCARD_FIRST);
-    *outRef = out;
+    AppendChar(out, ']');
 }
 
 enum interpretStep
@@ -687,206 +2351,514 @@ enum interpretStep
     SUB,
     LINK
 };
-char* InterpretAddMonadsRecursive(Monad* selectedMonad , const char* in)
+
+// A link read from text, kept as ordinals until every object it can reach has been made.
+typedef struct LinkFixup
+{
+    MonadId container; // object whose link section it was written in, which holds it.
+    unsigned int start; // ordinal of the start among the container's sub-objects.
+    unsigned int jumpBy; // containers to climb from the container before turning down.
+    unsigned int firstTurn; // where its turns begin in LinkFixups.turns, the last one reaches the end.
+    unsigned int turnCount;
+    bool reverse; // the link runs from the end to the start.
+} LinkFixup;
+
+typedef struct LinkFixups
+{
+    LinkFixup* fixups;
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int* turns;
+    unsigned int turnCount;
+    unsigned int turnCapacity;
+} LinkFixups;
+
+void PushLinkTurn(LinkFixups* fixups, unsigned int ordinal)
+{
+    if (fixups->turnCount == fixups->turnCapacity)
+    {
+        fixups->turnCapacity = fixups->turnCapacity ? fixups->turnCapacity * 2 : 64;
+        fixups->turns = realloc(fixups->turns, fixups->turnCapacity * sizeof(unsigned int));
+    }
+    fixups->turns[fixups->turnCount++] = ordinal;
+}
+
+void PushLinkFixup(LinkFixups* fixups, LinkFixup fixup)
+{
+    if (fixups->count == fixups->capacity)
+    {
+        fixups->capacity = fixups->capacity ? fixups->capacity * 2 : 64;
+        fixups->fixups = realloc(fixups->fixups, fixups->capacity * sizeof(LinkFixup));
+    }
+    fixups->fixups[fixups->count++] = fixup;
+}
+
+// A run of characters inside the text being read, not terminated.
+typedef struct TextSlice
+{
+    const char* text;
+    unsigned int length;
+} TextSlice;
+
+// Takes the name or ID starting at in, up to the next character the step gives a meaning. Nothing is copied.
+TextSlice NextPayload(const char* in, char step)
+{
+    return (TextSlice){ in , strcspn(in, step == LINK ? "[]:>;" : "[]:") };
+}
+
+// Makes the objects of one bracket beneath selectedMonad as they are read, and notes its links as fixups. Returns where the bracket ends.
+char* InterpretMonadsRecursive(MonadId selectedMonad , LinkFixups* fixups , const char* in)
 {
     char* progress = (char*)in + 1; //adding 1 assuming it's coming right after a '['.
-    char* payload = malloc(1);
-    payload[0] = '\0';
     unsigned int subCount = 0;
     char step = NAME;
+    unsigned int payloadIndex = 0;
+    LinkFixup fixup = { .container = selectedMonad };
     while (*progress != '\0')
     {
+        TextSlice payload = NextPayload(progress, step);
+        progress += payload.length;
+        if (*progress == '\0')
+            break;
+        if (step == LINK && memchr(payload.text, '?', payload.length))
+            fixup.reverse = true;
         switch(*progress)
         {
             case '[':
-                Vector2 oriV2 = selectedMonad->position;
+                Vector2 oriV2 = MONAD(selectedMonad, position);
                 Vector2 newV2 = (Vector2){oriV2.x + subCount*(oriV2.x < GetScreenWidth()/2 ? 60.1f : -60.1f) + 60.0f , oriV2.y + subCount*(oriV2.y < GetScreenHeight()/2 ? 60.0f : -60.0f)};
                 if(!IsVector2OnScreen(newV2))
                 {
                     newV2 = (Vector2){GetScreenWidth() - 70.0f , GetScreenHeight() - 70.0f};
                 }
-                progress = InterpretAddMonadsRecursive(AddMonad(newV2 , selectedMonad) , progress);
+                progress = InterpretMonadsRecursive(AddMonad(newV2 , selectedMonad) , fixups , progress);
                 subCount++;
             break;
             case ']':
-                free(payload);
                 return progress;
             case ':':
                 if (step == NAME)
                 {
-                    strncpy(selectedMonad->name, payload, MAX_MONAD_NAME_SIZE);
+                    SetMonadNameLength(selectedMonad, payload.text, payload.length);
                 }
-                free(payload);
-                payload = malloc(1);
-                payload[0] = '\0';
                 step++;
             break;
-            default:
-                if (step != LINK)
+            default: //'>' or ';', only found while reading links.
                 {
-                    char addChar[2] = {*progress , '\0'};
-                    payload = AppendMallocDiscard(payload , addChar , DISCARD_FIRST);
+                    unsigned int ordinal = DecodeID(payload.text, payload.length);
+                    if (*progress == ';') //the last turn reaches the end.
+                    {
+                        if (payloadIndex >= 2) //has its start and jump, turns are only noted past them.
+                        {
+                            PushLinkTurn(fixups, ordinal);
+                            fixup.turnCount = fixups->turnCount - fixup.firstTurn;
+                            PushLinkFixup(fixups, fixup);
+                        }
+                        fixup = (LinkFixup){ .container = selectedMonad };
+                        payloadIndex = 0;
+                    }
+                    else
+                    {
+                        if (payloadIndex == 0)
+                        {
+                            fixup.start = ordinal;
+                            fixup.firstTurn = fixups->turnCount;
+                        }
+                        else if (payloadIndex == 1)
+                            fixup.jumpBy = ordinal;
+                        else
+                            PushLinkTurn(fixups, ordinal);
+                        payloadIndex++;
+                    }
                 }
         }
         progress++;
     }
-    free(payload);
-    printf("Monad - no end bracket: %s\n" , selectedMonad->name);
+    printf("Monad - no end bracket: %s\n" , MonadNameText(selectedMonad));
     return progress;
 }
 
-typedef struct ParentedMonad
+// Reads text written by PrintMonadsRecursive into selectedMonad, which takes the name of the outermost object written.
+// Objects are made in one scan that notes every link as a fixup, links are made once everything they can reach exists, in the order they were read.
+void InterpretMonads(MonadId selectedMonad , const char* in)
 {
-    struct Monad* monad;
-    struct ParentedMonad* parentChain;
-} ParentedMonad;
-char* InterpretLinksRecursive(Monad* selectedMonad , ParentedMonad parentInfo , const char* in)
+    if (!in || in[0] == '\0')
+        return;
+
+    LinkFixups fixups = { 0 };
+    InterpretMonadsRecursive(selectedMonad , &fixups , in);
+    SiblingIndex siblings = BuildSiblingIndex(selectedMonad);
+    for (unsigned int i = 0; i < fixups.count; i++)
+    {
+        LinkFixup* fixup = &fixups.fixups[i];
+        MonadId startMonad = SubMonadOrFirst(&siblings, fixup->container, fixup->start);
+        MonadId endMonad = fixup->container;
+        for (unsigned int jump = 0; jump < fixup->jumpBy && endMonad != selectedMonad; jump++) //cannot climb out of what was pasted.
+            endMonad = MONAD(endMonad, container);
+        for (unsigned int turn = 0; turn < fixup->turnCount && endMonad; turn++)
+            endMonad = SubMonadOrFirst(&siblings, endMonad, fixups.turns[fixup->firstTurn + turn]);
+        if (!startMonad || !endMonad)
+            continue;
+        if (fixup->reverse)
+            AddLink(endMonad , startMonad , fixup->container);
+        else
+            AddLink(startMonad , endMonad , fixup->container);
+    }
+    FreeSiblingIndex(&siblings);
+    free(fixups.fixups);
+    free(fixups.turns);
+}
+
+// Positions have their own column, so rescaling streams through every slab instead of walking the tree.
+void ScreenResizeSync(float ratioX , float ratioY)
 {
-    char* progress = (char*)in + 1; //adding 1 assuming it's coming right after a '['.
-    char* payload = malloc(1);
-    Monad* rootMonadPtr = selectedMonad->rootSubMonads;
-    if (rootMonadPtr)
+    for (unsigned int slabIndex = 1; slabIndex < MonadTable.slabCount; slabIndex++)
     {
-        rootMonadPtr = rootMonadPtr->next;
+        if (!MonadTable.slabs[slabIndex]) //released.
+            continue;
+        MonadSlab* slab = (MonadSlab*)WritableSlab(&MonadTable, slabIndex);
+        for (unsigned int slot = 0; slot < SLAB_NODES; slot++)
+        {
+            slab->position[slot].x *= ratioX;
+            slab->position[slot].y *= ratioY;
+        }
     }
-    Monad* subIterator = rootMonadPtr;
-    Monad* findStartIterator = NULL;
-    Monad* findEnderIterator = NULL;
-    payload[0] = '\0';
-    char payloadIndex = 0;
-    char step = NAME;
-    bool reverseLink = false;
-    while (*progress != '\0')
+}
+
+// Moves every Monad and Link into fresh slabs in the order RecursiveDraw visits them, then releases the old slabs.
+// Each node stays in the pool of its arena. Links whose ends are no longer in the tree are dropped.
+typedef struct Compaction
+{
+    MonadId* monadMap; // old handle to new handle.
+    LinkId* linkMap;
+    NodePool* monadPools; // new pools, indexed by ArenaId.
+    NodePool* linkPools;
+} Compaction;
+
+#define COMPACT_MIN_CHURN 4096
+
+void CompactMonadsRecursive(Compaction* compaction, MonadId monad, ArenaId homeArena)
+{
+    MonadId newMonad = PoolAlloc(&compaction->monadPools[homeArena]);
+    compaction->monadMap[monad] = newMonad;
+    MONAD_W(newMonad, position) = MONAD(monad, position);
+    MONAD_W(newMonad, depth) = MONAD(monad, depth);
+    MONAD_W(newMonad, name) = MONAD(monad, name);
+    MONAD_W(newMonad, arena) = MONAD(monad, arena);
+    MONAD_W(newMonad, peakBytes) = MONAD(monad, peakBytes);
+    MONAD_W(newMonad, subCount) = MONAD(monad, subCount);
+    MONAD_W(newMonad, endLinks)[LINK_OUT] = 0;
+    MONAD_W(newMonad, endLinks)[LINK_IN] = 0;
+
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
     {
-        switch(*progress)
+        MonadId iterator = rootMonad;
+        do
         {
-            case '[':
-            if (subIterator)
+            CompactMonadsRecursive(compaction, iterator, MONAD(monad, arena));
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// Runs once every Monad has its new handle: rewires the new Monads and copies their links.
+// Subtree counts are rebuilt on the way back up, so dropped links stop being accounted for.
+void CompactLinksRecursive(Compaction* compaction, MonadId monad)
+{
+    MonadId* monadMap = compaction->monadMap;
+    MonadId newMonad = monadMap[monad];
+    MONAD_W(newMonad, rootSubMonads) = monadMap[MONAD(monad, rootSubMonads)];
+    MONAD_W(newMonad, next) = monadMap[MONAD(monad, next)];
+    MONAD_W(newMonad, prev) = monadMap[MONAD(monad, prev)];
+    MONAD_W(newMonad, container) = monadMap[MONAD(monad, container)];
+    MONAD_W(newMonad, subtreeMonads) = 1;
+    MONAD_W(newMonad, subtreeLinks) = 0;
+
+    LinkId rootLink = MONAD(monad, rootSubLink);
+    LinkId newRootLink = 0;
+    LinkId newLastLink = 0;
+    if (rootLink)
+    {
+        LinkId iterator = rootLink;
+        do
+        {
+            Link* iteratorPtr = LINK(iterator);
+            if (monadMap[iteratorPtr->startMonad] && monadMap[iteratorPtr->endMonad])
             {
-                progress = InterpretLinksRecursive(subIterator , (ParentedMonad){selectedMonad , &parentInfo} , progress);
-                subIterator = subIterator->next;
+                LinkId newLink = PoolAlloc(&compaction->linkPools[MONAD(monad, arena)]);
+                LINK_W(newLink)->startMonad = monadMap[iteratorPtr->startMonad];
+                LINK_W(newLink)->endMonad = monadMap[iteratorPtr->endMonad];
+                LINK_W(newLink)->container = newMonad;
+                ClaimLinkPair(LINK(newLink)->startMonad, LINK(newLink)->endMonad)->link = newLink;
+                AttachLinkEnd(newLink, LINK_OUT);
+                AttachLinkEnd(newLink, LINK_IN);
+                LINK_W(newLink)->prev = newLastLink;
+                if (newLastLink)
+                    LINK_W(newLastLink)->next = newLink;
+                else
+                    newRootLink = newLink;
+                newLastLink = newLink;
+                compaction->linkMap[iterator] = newLink;
+                MONAD_W(newMonad, subtreeLinks)++;
             }
-            break;
-            case ']':
-                free(payload);
-                return progress;
-            case ':':
-                free(payload);
-                payload = malloc(1);
-                payload[0] = '\0';
-                payloadIndex = 0;
-                step++;
-            break;
-            case '?':
-                reverseLink = true;
-            break;
-            case ';':
-                if(findEnderIterator && (findEnderIterator = findEnderIterator->rootSubMonads) && step == LINK)
-                {
-                    Monad* rootEnderIterator = findEnderIterator;
-                    unsigned int endIndex = 0;
-                    do
-                    {
-                        if (!strcmp(GenerateIDMalloc(endIndex) , payload))
-                        {
-                            break;
-                        }
-                        findEnderIterator = findEnderIterator->next;
-                        endIndex++;
-                    } while (findEnderIterator != rootEnderIterator);
-                    if (reverseLink)
-                        AddLink(findEnderIterator , findStartIterator , selectedMonad);
-                    else
-                        AddLink(findStartIterator , findEnderIterator , selectedMonad);
-                }
-                free(payload);
-                payload = malloc(1);
-                payload[0] = '\0';
-                payloadIndex = 0;
-                reverseLink = false;
-            break;
-            case '>':
-                if (rootMonadPtr && step == LINK)
-                {
-                    switch (payloadIndex)
-                    {
-                        case 0:
-                            findStartIterator = rootMonadPtr;
-                            unsigned int startIndex = 0;
-                            do
-                            {
-                                if (!strcmp(GenerateIDMalloc(startIndex) , payload))
-                                    break;
-                                findStartIterator = findStartIterator->next;
-                                startIndex++;
-                            } while (findStartIterator != rootMonadPtr);
-                            payloadIndex++;
-                        break;
-                        case 1://jump
-                            findEnderIterator = selectedMonad;
-                            ParentedMonad* currentChain = &parentInfo;
-                            unsigned int jumpIndex = 0;
-                            while (currentChain && currentChain->monad && currentChain->parentChain && strcmp(GenerateIDMalloc(jumpIndex) , payload)) 
-                            {
-                                findEnderIterator = currentChain->monad;
-                                currentChain = currentChain->parentChain;
-                                jumpIndex++;
-                            }
-                            payloadIndex++;
-                        break;
-                        case 2:
-                            findEnderIterator = findEnderIterator->rootSubMonads;
-                                Monad* rootEnderIterator = findEnderIterator;
-                                unsigned int endIndex = 0;
-                                do
-                                {
-                                    if (!strcmp(GenerateIDMalloc(endIndex) , payload))
-                                        break;
-                                    findEnderIterator = findEnderIterator->next;
-                                    endIndex++;
-                                } while (findEnderIterator != rootEnderIterator);
-                    }
-                }
-                free(payload);
-                payload = malloc(1);
-                payload[0] = '\0';
-            break;
-            default:
-                if(step == LINK)
-                {
-                    char addChar[2] = {*progress , '\0'};
-                    payload = AppendMallocDiscard(payload , addChar , DISCARD_FIRST);
-                }
+            iterator = iteratorPtr->next;
+        } while (iterator != rootLink);
+        if (newLastLink)
+        {
+            LINK_W(newLastLink)->next = newRootLink;
+            LINK_W(newRootLink)->prev = newLastLink;
         }
-        progress++;
     }
-    return progress;
+    MONAD_W(newMonad, rootSubLink) = newRootLink;
+
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
+    if (rootMonad)
+    {
+        MonadId iterator = rootMonad;
+        do
+        {
+            CompactLinksRecursive(compaction, iterator);
+            MONAD_W(newMonad, subtreeMonads) += MONAD(monadMap[iterator], subtreeMonads);
+            MONAD_W(newMonad, subtreeLinks) += MONAD(monadMap[iterator], subtreeLinks);
+            iterator = MONAD(iterator, next);
+        } while (iterator != rootMonad);
+    }
+}
+
+// Whether the entry holds an object that is out of the tree.
+bool JournalHoldsMonad(unsigned int entryIndex)
+{
+    unsigned char op = MonadJournal.entries[entryIndex].op;
+    return (op == JOURNAL_REMOVE_MONAD && entryIndex < MonadJournal.done) || (op == JOURNAL_ADD_MONAD && entryIndex >= MonadJournal.done);
+}
+
+// *heldMonads[0] must be the root of the whole tree. Every handle pointed to is updated to its new value, 0 if it was dropped.
+// Objects only the journal holds and the copy held for pasting are moved along with the tree, and the journal is updated too.
+void CompactMonads(MonadId* heldMonads[], unsigned int heldMonadCount, LinkId* heldLinks[], unsigned int heldLinkCount)
+{
+    unsigned int arenaCount = ArenaCapacity ? ArenaCapacity : 1;
+    Compaction compaction;
+    compaction.monadMap = calloc(((size_t)MonadTable.slabCount << SLAB_SHIFT) + 1, sizeof(MonadId)); // + 1 so handle 0 always maps.
+    compaction.linkMap = calloc(((size_t)LinkTable.slabCount << SLAB_SHIFT) + 1, sizeof(LinkId));
+    compaction.monadPools = calloc(arenaCount, sizeof(NodePool));
+    compaction.linkPools = calloc(arenaCount, sizeof(NodePool));
+    for (unsigned int i = 0; i < arenaCount; i++)
+    {
+        compaction.monadPools[i].table = &MonadTable;
+        compaction.linkPools[i].table = &LinkTable;
+    }
+
+    MonadId root = *heldMonads[0];
+    CompactMonadsRecursive(&compaction, root, 0);
+    for (unsigned int i = 0; i < MonadJournal.count; i++)
+    {
+        if (!JournalHoldsMonad(i))
+            continue;
+        MonadId held = MonadJournal.entries[i].monad;
+        ArenaId arena = MONAD(held, arena);
+        CompactMonadsRecursive(&compaction, held, (arena && ArenaOf(arena)->owner == held) ? ArenaOf(arena)->parentArena : arena);
+    }
+    if (CopiedMonad)
+        CompactMonadsRecursive(&compaction, CopiedMonad, 0);
+    if (LinkPairs.slots) //every handle changes, the index is refilled as links are copied.
+        memset(LinkPairs.slots, 0, LinkPairs.slotCapacity * sizeof(LinkPair));
+    LinkPairs.slotCount = 0;
+    CompactLinksRecursive(&compaction, root);
+    for (unsigned int i = 0; i < MonadJournal.count; i++)
+    {
+        if (JournalHoldsMonad(i))
+            CompactLinksRecursive(&compaction, MonadJournal.entries[i].monad);
+    }
+    if (CopiedMonad)
+        CompactLinksRecursive(&compaction, CopiedMonad);
+    for (unsigned int i = 0; i < MonadJournal.count; i++)
+    {
+        JournalEntry* entry = &MonadJournal.entries[i];
+        entry->monad = compaction.monadMap[entry->monad];
+        entry->mate = compaction.monadMap[entry->mate];
+        entry->container = compaction.monadMap[entry->container];
+        if (entry->op == JOURNAL_ADD_LINK || entry->op == JOURNAL_REMOVE_LINK)
+        {
+            entry->swap.prevLink.start = compaction.monadMap[entry->swap.prevLink.start];
+            entry->swap.prevLink.end = compaction.monadMap[entry->swap.prevLink.end];
+        }
+    }
+
+    for (ArenaId arenaId = 0; arenaId < arenaCount; arenaId++)
+    {
+        if (arenaId && !ArenaTable[arenaId])
+            continue;
+        MonadArena* arena = ArenaOf(arenaId);
+        PoolReleaseAll(&arena->monads);
+        PoolReleaseAll(&arena->links);
+        arena->monads = compaction.monadPools[arenaId];
+        arena->links = compaction.linkPools[arenaId];
+        arena->owner = compaction.monadMap[arena->owner];
+    }
+
+    for (unsigned int i = 0; i < heldMonadCount; i++)
+        *heldMonads[i] = compaction.monadMap[*heldMonads[i]];
+    CopiedMonad = compaction.monadMap[CopiedMonad];
+    for (unsigned int i = 0; i < heldLinkCount; i++)
+        *heldLinks[i] = compaction.linkMap[*heldLinks[i]];
+
+    free(compaction.monadMap);
+    free(compaction.linkMap);
+    free(compaction.monadPools);
+    free(compaction.linkPools);
+    NodeChurn = 0;
+}
+
+unsigned int LiveNodeCount(void)
+{
+    unsigned int count = GlobalArena.monads.liveNodes + GlobalArena.links.liveNodes;
+    for (ArenaId arenaId = 1; arenaId < ArenaCapacity; arenaId++)
+    {
+        if (ArenaTable[arenaId])
+            count += ArenaTable[arenaId]->monads.liveNodes + ArenaTable[arenaId]->links.liveNodes;
+    }
+    return count;
+}
+
+// Compaction pays off once at least as many nodes have been freed as are still alive.
+bool CompactionDue(void)
+{
+    return NodeChurn >= COMPACT_MIN_CHURN && NodeChurn >= LiveNodeCount();
+}
+
+// Every Monad and Link as they were when the snapshot was taken. Taking one only shares the current slab lists,
+// the live tables copy a slab the first time they write to it afterwards. Handles of that time mean the same nodes in it.
+typedef struct MonadSnapshot
+{
+    char** monadSlabs;
+    unsigned int monadSlabCount;
+    char** linkSlabs;
+    unsigned int linkSlabCount;
+    MonadId root;
+} MonadSnapshot;
+
+MonadSnapshot TakeSnapshot(MonadId root)
+{
+    MonadSnapshot snapshot = { MonadTable.slabs , MonadTable.slabCount , LinkTable.slabs , LinkTable.slabCount , root };
+    SLAB_HOLDERS(MonadTable.slabs)++;
+    if (LinkTable.slabs)
+        SLAB_HOLDERS(LinkTable.slabs)++;
+    SnapshotCount++;
+    return snapshot;
+}
+
+void FreeSnapshot(MonadSnapshot* snapshot)
+{
+    if (!snapshot->root) //never taken.
+        return;
+    DropSlabList(snapshot->monadSlabs, snapshot->monadSlabCount);
+    DropSlabList(snapshot->linkSlabs, snapshot->linkSlabCount);
+    SnapshotCount--;
+    *snapshot = (MonadSnapshot){ 0 };
+}
+
+// Slabs the live tables hold that differ from the snapshot, so a diff only has to look inside these.
+unsigned int SlabsChangedSince(const MonadSnapshot* snapshot)
+{
+    unsigned int changed = 0;
+    for (unsigned int i = 1; i < MonadTable.slabCount || i < snapshot->monadSlabCount; i++)
+        changed += (i < MonadTable.slabCount ? MonadTable.slabs[i] : NULL) != (i < snapshot->monadSlabCount ? snapshot->monadSlabs[i] : NULL);
+    for (unsigned int i = 1; i < LinkTable.slabCount || i < snapshot->linkSlabCount; i++)
+        changed += (i < LinkTable.slabCount ? LinkTable.slabs[i] : NULL) != (i < snapshot->linkSlabCount ? snapshot->linkSlabs[i] : NULL);
+    return changed;
+}
+
+typedef struct SnapshotView
+{
+    SlabTable monads;
+    SlabTable links;
+} SnapshotView;
+
+// Points the tables at the snapshot so everything reading the tree reads it instead, until EndSnapshotView. Nothing may be added or removed meanwhile.
+// Columns written while viewing, such as the ones the indices fill in, are copied into slabs of the view's own and thrown away at the end.
+SnapshotView BeginSnapshotView(const MonadSnapshot* snapshot)
+{
+    SnapshotView live = { MonadTable , LinkTable };
+    MonadTable.slabs = snapshot->monadSlabs;
+    MonadTable.slabCount = MonadTable.slabCapacity = snapshot->monadSlabCount;
+    SLAB_HOLDERS(MonadTable.slabs)++;
+    LinkTable.slabs = snapshot->linkSlabs;
+    LinkTable.slabCount = LinkTable.slabCapacity = snapshot->linkSlabCount;
+    if (LinkTable.slabs)
+        SLAB_HOLDERS(LinkTable.slabs)++;
+    SnapshotCount++;
+    return live;
+}
+
+void EndSnapshotView(const SnapshotView* live)
+{
+    DropSlabList(MonadTable.slabs, MonadTable.slabCount);
+    DropSlabList(LinkTable.slabs, LinkTable.slabCount);
+    MonadTable = live->monads;
+    LinkTable = live->links;
+    SnapshotCount--;
+}
+
+// Writes the whole tree of the snapshot as text, the same as copying its root would have when it was taken.
+char* PrintSnapshotMalloc(const MonadSnapshot* snapshot)
+{
+    TextBuilder out = { 0 };
+    SnapshotView live = BeginSnapshotView(snapshot);
+    AncestorIndex ancestors = BuildAncestorIndex(snapshot->root);
+    SiblingIndex siblings = BuildSiblingIndex(snapshot->root);
+    PrintMonadsRecursive(snapshot->root , &ancestors , &siblings , &out);
+    FreeAncestorIndex(&ancestors);
+    FreeSiblingIndex(&siblings);
+    EndSnapshotView(&live);
+    return out.text;
 }
 
-void ScreenResizeSyncRecursive(Monad* monad , float ratioX , float ratioY)
+float TraverseRecursive(MonadId monad)
 {
-    monad->position.x *= ratioX;
-    monad->position.y *= ratioY;
-    Monad* rootMonad = monad->rootSubMonads;
+    float sum = MONAD(monad, position).x;
+    LinkId rootLink = MONAD(monad, rootSubLink);
+    if (rootLink)
+    {
+        LinkId iterator = rootLink;
+        do
+        {
+            sum += MONAD(LINK(iterator)->endMonad, position).y;
+            iterator = LINK(iterator)->next;
+        } while (iterator != rootLink);
+    }
+    MonadId rootMonad = MONAD(monad, rootSubMonads);
     if (rootMonad)
     {
-        Monad* iterator = rootMonad;
+        MonadId iterator = rootMonad;
         do
         {
-            ScreenResizeSyncRecursive(iterator , ratioX , ratioY);
-            iterator = iterator->next;
+            sum += TraverseRecursive(iterator);
+            iterator = MONAD(iterator, next);
         } while (iterator != rootMonad);
     }
+    return sum;
+}
+
+// Seconds taken to visit every Monad and Link the way RecursiveDraw does, without drawing.
+double TimeTraversal(MonadId root)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    volatile float sum = TraverseRecursive(root);
+    (void)sum;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
 }
 
 #include <stdlib.h>
-void MonadsStressTest(Monad* monad , Monad* lastMonad , Link* lastLink , Monad* lastLinkContainer , unsigned int limit)
+void MonadsStressTest(MonadId monad , MonadId lastMonad , LinkId lastLink , MonadId lastLinkContainer , unsigned int limit)
 {
     if (!limit)
         return;
-    if (lastMonad->rootSubLink) // don't only delete the only link.
+    if (MONAD(lastMonad, rootSubLink)) // don't only delete the only link.
     {
-        lastLink = lastMonad->rootSubLink;
+        lastLink = MONAD(lastMonad, rootSubLink);
         lastLinkContainer = lastMonad;
     }
     switch(rand() % 4)
@@ -900,24 +2872,24 @@ void MonadsStressTest(Monad* monad , Monad* lastMonad , Link* lastLink , Monad*
         case 2://rem monad, stay
         if(lastLink)
         {
-            Monad* start = lastLink->startMonad;
+            MonadId start = LINK(lastLink)->startMonad;
             RemoveLink(lastLink , lastLinkContainer);
-            MonadsStressTest( start , lastLinkContainer , NULL , NULL , limit - 1 );
+            MonadsStressTest( start , lastLinkContainer , 0 , 0 , limit - 1 );
             break;
         }
         case 3://add link, switch to endpoint, keep height
         int cycles = rand() % 3;
-        Monad* start = monad;
+        MonadId start = monad;
         while (cycles)
         {
-            start = start->next;
+            start = MONAD(start, next);
             cycles--;
         }
         cycles = rand() % 3;
-        Monad* end = start;
+        MonadId end = start;
         while (cycles)
         {
-            end = end->next;
+            end = MONAD(end, next);
             cycles--;
         }
         MonadsStressTest(end , lastMonad , AddLink(start , end , lastMonad) , lastMonad , limit - 1);
@@ -925,12 +2897,12 @@ void MonadsStressTest(Monad* monad , Monad* lastMonad , Link* lastLink , Monad*
     }
 }
 
-void MonadsExample(Monad* GodMonad)
+void MonadsExample(MonadId GodMonad)
 {
     AddLink( AddMonad((Vector2) { 600, 500 }, GodMonad) , AddMonad((Vector2) { 200, 400 }, GodMonad) , GodMonad);
-    Monad* interLinkExample = AddMonad((Vector2) { 100, 100 }, AddMonad((Vector2) { 350, 200 }, GodMonad));
-    Monad* example = AddMonad((Vector2) { 400, 400 }, GodMonad);
-    Monad* interLinkExample2 = AddMonad((Vector2) { 440, 410 }, example);
+    MonadId interLinkExample = AddMonad((Vector2) { 100, 100 }, AddMonad((Vector2) { 350, 200 }, GodMonad));
+    MonadId example = AddMonad((Vector2) { 400, 400 }, GodMonad);
+    MonadId interLinkExample2 = AddMonad((Vector2) { 440, 410 }, example);
     AddLink(AddMonad((Vector2) { 400, 450 }, example) , AddMonad((Vector2) { 500, 500 }, example) , example);
     AddLink(interLinkExample , interLinkExample2 , example);
 }
@@ -948,42 +2920,173 @@ int main(void)
 
     // Variables
     //--------------------------------------------------------------------------------------
-    Monad* GodMonad = malloc(sizeof(Monad));
-    memset(GodMonad, 0, sizeof(Monad));
+    MonadId GodMonad = PoolAlloc(&GlobalArena.monads);
+    ClearMonad(GodMonad);
 
-    GodMonad->position.x = screenWidth / 2.0f;
-    GodMonad->position.y = screenHeight / 2.0f;
-    GodMonad->next = GodMonad;
-    strcpy(GodMonad->name, "Monad 0");
+    MONAD_W(GodMonad, position).x = screenWidth / 2.0f;
+    MONAD_W(GodMonad, position).y = screenHeight / 2.0f;
+    MONAD_W(GodMonad, next) = GodMonad;
+    SetMonadName(GodMonad, "Monad 0");
 
     Vector2 mouseV2;
-    char monadLog[MAX_MONAD_NAME_SIZE * 3] = "Session started.";
-    Monad* selectedMonad = NULL;
-    Link* selectedLink = NULL;
+    char monadLog[MAX_MONAD_NAME_SIZE * 4] = "Session started.";
+    MonadId selectedMonad = 0;
+    LinkId selectedLink = 0;
+    MonadId grabbedMonad = 0;
     unsigned int selectedDepth = 0;
     unsigned int selectedMonadDepth = 0;
     ActiveResult mainResult = (ActiveResult){ 0 };
     bool selectDrag = false;
+    bool showMemoryUsage = false;
+    MonadSnapshot lastSnapshot = { 0 };
 
     int backspaceDelay = 0;
     //--------------------------------------------------------------------------------------
 
     // Testing
     //--------------------------------------------------------------------------------------
-    #include <time.h>
     struct timespec start, end;
-    Monad* pseudoGodMonad = AddMonad((Vector2){100,100} , GodMonad);
-    clock_gettime(CLOCK_MONOTONIC, &start);
-        MonadsStressTest(AddMonad((Vector2){100,150} , pseudoGodMonad) , pseudoGodMonad , NULL , NULL , 10000);
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    printf("MonadsStressTest() time taken: %.6f seconds\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
-    clock_gettime(CLOCK_MONOTONIC, &start);
-        RemoveSubMonadsRecursive(pseudoGodMonad);
-    clock_gettime(CLOCK_MONOTONIC, &end);
-    printf("RemoveSubMonadsRecursive() time taken: %.6f seconds\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
-    GodMonad->rootSubMonads = NULL;
+    for (int useArena = 0; useArena <= 1; useArena++) // Same workload with and without an arena.
+    {
+        srand(1);
+        MonadId pseudoGodMonad = AddMonad((Vector2){100,100} , GodMonad);
+        if (useArena)
+            EnableMonadArena(pseudoGodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            MonadsStressTest(AddMonad((Vector2){100,150} , pseudoGodMonad) , pseudoGodMonad , 0 , 0 , 10000);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("MonadsStressTest()%s time taken: %.6f seconds, %u live slabs\n", useArena ? " (arena)" : "", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, LiveSlabCount);
+        double traversalBefore = TimeTraversal(GodMonad);
+        MonadId* heldMonads[] = { &GodMonad , &pseudoGodMonad };
+        CompactMonads(heldMonads , 2 , NULL , 0);
+        printf("CompactMonads()%s traversal before: %.6f seconds, after: %.6f seconds, %u live slabs\n", useArena ? " (arena)" : "", traversalBefore, TimeTraversal(GodMonad), LiveSlabCount);
+        DumpMemoryUsageRecursive(GodMonad, 0, 1);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            RemoveMonad(pseudoGodMonad, GodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("RemoveMonad()%s time taken: %.6f seconds, %u live slabs\n", useArena ? " (arena)" : "", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, LiveSlabCount);
+    }
+    {
+        // The same random tree built node by node and in bulk.
+        enum { BULK_MONADS = 100000, BULK_LINKS = 50000 };
+        int* parents = malloc(BULK_MONADS * sizeof(int));
+        int* depths = malloc(BULK_MONADS * sizeof(int));
+        unsigned int (*links)[2] = malloc(BULK_LINKS * sizeof(*links));
+        MonadId* handles = malloc(BULK_MONADS * sizeof(MonadId));
+        srand(1);
+        for (int i = 0; i < BULK_MONADS; i++)
+        {
+            parents[i] = rand() % (i + 1) - 1;
+            depths[i] = parents[i] < 0 ? 0 : depths[parents[i]] + 1;
+        }
+        for (int i = 0; i < BULK_LINKS; i++) //both ends at the same depth.
+        {
+            links[i][0] = rand() % BULK_MONADS;
+            do
+                links[i][1] = rand() % BULK_MONADS;
+            while (depths[links[i][1]] != depths[links[i][0]]);
+        }
+
+        MonadId pseudoGodMonad = AddMonad((Vector2){100,100} , GodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int i = 0; i < BULK_MONADS; i++)
+                handles[i] = AddMonad((Vector2){500,500} , parents[i] < 0 ? pseudoGodMonad : handles[parents[i]]);
+            for (int i = 0; i < BULK_LINKS; i++)
+                AddLink(handles[links[i][0]] , handles[links[i][1]] , MONAD(handles[links[i][0]], container));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("AddMonad() x%d time taken: %.6f seconds, traversal: %.6f seconds\n", BULK_MONADS, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, TimeTraversal(GodMonad));
+        RemoveMonad(pseudoGodMonad, GodMonad);
+
+        pseudoGodMonad = AddMonad((Vector2){100,100} , GodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            BulkAddMonads(pseudoGodMonad , BULK_MONADS , parents , NULL , NULL , links , BULK_LINKS , handles);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("BulkAddMonads() x%d time taken: %.6f seconds, traversal: %.6f seconds\n", BULK_MONADS, (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, TimeTraversal(GodMonad));
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            TextBuilder out = { 0 };
+            AncestorIndex ancestors = BuildAncestorIndex(pseudoGodMonad);
+            SiblingIndex siblings = BuildSiblingIndex(pseudoGodMonad);
+            PrintMonadsRecursive(pseudoGodMonad , &ancestors , &siblings , &out);
+            FreeAncestorIndex(&ancestors);
+            FreeSiblingIndex(&siblings);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double printSeconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("PrintMonadsRecursive() x%d time taken: %.6f seconds, %zu characters, %.1f MB/s\n", BULK_MONADS, printSeconds, out.length, out.length / printSeconds / 1e6);
+        free(out.text);
+        DumpMemoryUsageRecursive(GodMonad, 0, 1);
+        RemoveMonad(pseudoGodMonad, GodMonad);
+        free(parents);
+        free(depths);
+        free(links);
+        free(handles);
+    }
+    {
+        // Snapshot a tree, edit it, and write out the snapshot as it was.
+        MonadId pseudoGodMonad = AddMonad((Vector2){100,100} , GodMonad);
+        srand(1);
+        MonadsStressTest(AddMonad((Vector2){100,150} , pseudoGodMonad) , pseudoGodMonad , 0 , 0 , 10000);
+        unsigned int copiesBefore = SlabCopies;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            MonadSnapshot snapshot = TakeSnapshot(GodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("TakeSnapshot() time taken: %.9f seconds\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+        MonadsStressTest(AddMonad((Vector2){100,150} , pseudoGodMonad) , pseudoGodMonad , 0 , 0 , 200);
+        printf("Edits after the snapshot copied %u slabs, %u slabs differ, %u live slabs\n", SlabCopies - copiesBefore, SlabsChangedSince(&snapshot), LiveSlabCount);
+        copiesBefore = SlabCopies;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            char* out = PrintSnapshotMalloc(&snapshot);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("PrintSnapshotMalloc() time taken: %.6f seconds, %zu characters, %u slabs copied\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, strlen(out), SlabCopies - copiesBefore);
+        free(out);
+        RemoveMonad(pseudoGodMonad, GodMonad);
+        FreeSnapshot(&snapshot);
+    }
+
+    {
+        // The same tree copied by writing it out as text and reading it back, and by cloning it.
+        MonadId pseudoGodMonad = AddMonad((Vector2){100,100} , GodMonad);
+        srand(1);
+        MonadsStressTest(AddMonad((Vector2){100,150} , pseudoGodMonad) , pseudoGodMonad , 0 , 0 , 2000);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            TextBuilder out = { 0 };
+            AncestorIndex ancestors = BuildAncestorIndex(pseudoGodMonad);
+            SiblingIndex siblings = BuildSiblingIndex(pseudoGodMonad);
+            PrintMonadsRecursive(pseudoGodMonad , &ancestors , &siblings , &out);
+            FreeAncestorIndex(&ancestors);
+            FreeSiblingIndex(&siblings);
+            MonadId pastedMonad = AddMonad((Vector2){100,100} , GodMonad);
+            InterpretMonads(pastedMonad , out.text);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("Text copy of %u objects time taken: %.6f seconds\n", MONAD(pseudoGodMonad, subtreeMonads), (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            MonadId clonedMonad = CloneMonad(pseudoGodMonad , (Vector2){100,100} , GodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("CloneMonad() time taken: %.6f seconds\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+        TextBuilder clonedOut = { 0 };
+        ancestors = BuildAncestorIndex(clonedMonad);
+        siblings = BuildSiblingIndex(clonedMonad);
+        PrintMonadsRecursive(clonedMonad , &ancestors , &siblings , &clonedOut);
+        FreeAncestorIndex(&ancestors);
+        FreeSiblingIndex(&siblings);
+        printf("Cloned tree %s the original, %u objects and %u links\n", strcmp(out.text, clonedOut.text) ? "differs from" : "matches", MONAD(clonedMonad, subtreeMonads), MONAD(clonedMonad, subtreeLinks));
+        free(out.text);
+        free(clonedOut.text);
+        MonadId movedMonad = MONAD(clonedMonad, rootSubMonads);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            ReparentMonad(movedMonad , pseudoGodMonad);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("ReparentMonad() of %u objects and %u links at the same depth time taken: %.9f seconds\n", MONAD(movedMonad, subtreeMonads), MONAD(movedMonad, subtreeLinks), (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+            ReparentMonad(movedMonad , MONAD(pastedMonad, rootSubMonads));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("ReparentMonad() one level down time taken: %.9f seconds\n", (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+        RemoveMonad(clonedMonad, GodMonad);
+        RemoveMonad(pastedMonad, GodMonad);
+        RemoveMonad(pseudoGodMonad, GodMonad);
+    }
     
     MonadsExample(GodMonad);// Original example.
+    MonadJournal.recording = true;
     //--------------------------------------------------------------------------------------
 
     // Main loop
@@ -993,11 +3096,62 @@ int main(void)
         int newScreenHeight = GetScreenHeight();
         if (screenWidth != newScreenWidth || screenHeight != newScreenHeight)
         {
-            ScreenResizeSyncRecursive(GodMonad , (float){newScreenWidth}/(float){screenWidth} , (float){newScreenHeight}/(float){screenHeight});
+            ScreenResizeSync((float){newScreenWidth}/(float){screenWidth} , (float){newScreenHeight}/(float){screenHeight});
             screenWidth = newScreenWidth;
             screenHeight = newScreenHeight;
         }
         mouseV2 = GetMousePosition();
+        BeginJournalStep();
+        if (TypedName.monad && (TypedName.monad != selectedMonad || IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL) || IsKeyDown(KEY_LEFT_ALT) || IsKeyDown(KEY_RIGHT_ALT)
+            || IsKeyDown(KEY_DELETE) || IsMouseButtonPressed(MOUSE_BUTTON_LEFT) || IsMouseButtonPressed(MOUSE_BUTTON_RIGHT) || CompactionDue()))
+        {
+            EndNameEdit(); //anything but typing ends the edit, before it can select, remove or move the object.
+            BeginJournalStep(); //whatever ended it is undone on its own.
+        }
+        if (((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_M)) || CompactionDue())
+        {
+            double traversalBefore = TimeTraversal(GodMonad);
+            MonadId* heldMonads[] = { &GodMonad , &selectedMonad , &grabbedMonad };
+            LinkId* heldLinks[] = { &selectedLink };
+            CompactMonads(heldMonads , 3 , heldLinks , 1);
+            double traversalAfter = TimeTraversal(GodMonad);
+            snprintf(monadLog, sizeof(monadLog), "Compacted memory, traversal %.3fms to %.3fms.", traversalBefore * 1000.0, traversalAfter * 1000.0);
+            printf("CompactMonads() traversal before: %.6f seconds, after: %.6f seconds\n", traversalBefore, traversalAfter);
+        }
+        if ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_U))
+            showMemoryUsage = !showMemoryUsage;
+        if ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && (IsKeyPressed(KEY_Z) || IsKeyPressed(KEY_Y)))
+        {
+            bool undoing = IsKeyPressed(KEY_Z);
+            unsigned int replayed = undoing ? UndoJournalStep() : RedoJournalStep();
+            if (replayed)
+            {
+                snprintf(monadLog, sizeof(monadLog), "%s %u changes.", undoing ? "Undid" : "Redid", replayed);
+                selectedMonad = 0; //may no longer be in the tree.
+                selectedLink = 0;
+                grabbedMonad = 0;
+            }
+            else
+                strcpy(monadLog, undoing ? "Nothing to undo." : "Nothing to redo.");
+        }
+        if ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_S))
+        {
+            FreeSnapshot(&lastSnapshot);
+            lastSnapshot = TakeSnapshot(GodMonad);
+            strcpy(monadLog, "Snapshot taken.");
+        }
+        if ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_L))
+        {
+            if (lastSnapshot.root)
+            {
+                char* out = PrintSnapshotMalloc(&lastSnapshot);
+                SetClipboardText(out);
+                free(out);
+                snprintf(monadLog, sizeof(monadLog), "Copied the snapshot, %u slabs changed since.", SlabsChangedSince(&lastSnapshot));
+            }
+            else
+                strcpy(monadLog, "No snapshot taken yet.");
+        }
         bool isCutting = IsKeyPressed(KEY_X);
         if(IsKeyDown(KEY_LEFT_ALT) || IsKeyDown(KEY_RIGHT_ALT))
         {
@@ -1008,12 +3162,12 @@ int main(void)
             if (selectedLink && IsKeyPressed(KEY_DELETE))
             {
                 strcpy(monadLog, "Link [");
-                strcat(monadLog, selectedLink->startMonad->name);
+                AppendLogName(monadLog, LINK(selectedLink)->startMonad);
                 strcat(monadLog, "] to [");
-                strcat(monadLog, selectedLink->endMonad->name);
+                AppendLogName(monadLog, LINK(selectedLink)->endMonad);
                 if (RemoveLink(selectedLink, selectedMonad))
                 {
-                    selectedLink = NULL;
+                    selectedLink = 0;
                     strcat(monadLog, "] deleted.");
                 }
                 else
@@ -1024,19 +3178,18 @@ int main(void)
                 if (selectedMonad == GodMonad)
                 {
                     strcpy(monadLog, "Cannot delete [");
-                    strcat(monadLog, selectedMonad->name);
+                    AppendLogName(monadLog, selectedMonad);
                     strcat(monadLog, "]: Is root.");
                 }
                 else
                 {
-                    if (!selectedMonad->deleteFrame)
-                    {
-                        strcpy(monadLog, "Deleted object [");
-                        strcat(monadLog, selectedMonad->name);
-                        strcat(monadLog, "].");
-                        selectedMonad->deleteFrame = DELETE_PRELINK;
-                    }
-                    selectedMonad = NULL;
+                    strcpy(monadLog, "Deleted object [");
+                    AppendLogName(monadLog, selectedMonad);
+                    strcat(monadLog, "].");
+                    RemoveMonad(selectedMonad, MONAD(selectedMonad, container));
+                    selectedMonad = 0;
+                    selectedLink = 0;
+                    grabbedMonad = 0;
                 }
             }
             else if(IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL))
@@ -1044,67 +3197,118 @@ int main(void)
                 if (selectedLink && IsKeyPressed(KEY_A))
                 {
                     strcpy(monadLog, "Link end object cycled from [");
-                    strcat(monadLog, selectedLink->endMonad->name);
+                    AppendLogName(monadLog, LINK(selectedLink)->endMonad);
                     strcat(monadLog, "] to [");
-                    Monad* newStartCycle = selectedLink->startMonad;
-                    Monad* newEndCycle = selectedLink->endMonad->next;
-                    RemoveLink(selectedLink , selectedMonad);
-                    while(!(selectedLink = AddLink(newStartCycle , newEndCycle , selectedMonad)))
-                        newEndCycle = newEndCycle->next;
-                    strcat(monadLog, selectedLink->endMonad->name);
+                    MonadId newStartCycle = LINK(selectedLink)->startMonad;
+                    MonadId newEndCycle = MONAD(LINK(selectedLink)->endMonad, next);
+                    MonadId linkContainer = LINK(selectedLink)->container; //selectedMonad may have changed since the link was selected.
+                    if (RemoveLink(selectedLink , linkContainer))
+                    {
+                        while(!(selectedLink = AddLink(newStartCycle , newEndCycle , linkContainer)))
+                            newEndCycle = MONAD(newEndCycle, next);
+                        AppendLogName(monadLog, LINK(selectedLink)->endMonad);
+                        strcat(monadLog, "].");
+                    }
+                    else
+                        strcpy(monadLog, "Link end object failed to cycle.");
+                }
+                else if (IsKeyPressed(KEY_R))
+                {
+                    if (EnableMonadArena(selectedMonad))
+                        strcpy(monadLog, "Arena given to [");
+                    else
+                        strcpy(monadLog, "Cannot give an arena to non-empty [");
+                    AppendLogName(monadLog, selectedMonad);
                     strcat(monadLog, "].");
                 }
+                else if (IsKeyPressed(KEY_D))
+                {
+                    strcpy(monadLog, "Dumped memory usage of [");
+                    AppendLogName(monadLog, selectedMonad);
+                    strcat(monadLog, "] to the console.");
+                    DumpMemoryUsageRecursive(selectedMonad, 0, 2);
+                    if (CopiedMonad)
+                    {
+                        printf("Held for pasting:\n");
+                        DumpMemoryUsageRecursive(CopiedMonad, 1, 1);
+                    }
+                }
                 else if (IsKeyPressed(KEY_T))
                 {
                     strcpy(monadLog, "Renamed [");
-                    strcat(monadLog, selectedMonad->name);
+                    AppendLogName(monadLog, selectedMonad);
                     strcat(monadLog, "] to [");
-                    strncpy(selectedMonad->name, GetClipboardText(), MAX_MONAD_NAME_SIZE);
-                    selectedMonad->name[MAX_MONAD_NAME_SIZE - 1] = '\0'; //ensures NULL termination.
-                    strcat(monadLog, selectedMonad->name);
+                    RenameMonad(selectedMonad, GetClipboardText());
+                    AppendLogName(monadLog, selectedMonad);
                     strcat(monadLog, "].");
                 }
-                else if (!selectedMonad->deleteFrame && IsKeyPressed(KEY_B))
+                else if (IsKeyPressed(KEY_B))
                 {
                     strcpy(monadLog, "Broke all links from and to [");
-                    strcat(monadLog, selectedMonad->name);
+                    AppendLogName(monadLog, selectedMonad);
                     strcat(monadLog, "].");
-                    selectedMonad->deleteFrame = DELETE_ONLYLINK;
+                    BreakMonadLinks(selectedMonad);
+                }
+                else if (IsKeyPressed(KEY_G))
+                {
+                    if (!grabbedMonad || grabbedMonad == selectedMonad)
+                    {
+                        grabbedMonad = selectedMonad;
+                        strcpy(monadLog, "Grabbed [");
+                        AppendLogName(monadLog, grabbedMonad);
+                        strcat(monadLog, "], select where it goes.");
+                    }
+                    else
+                    {
+                        strcpy(monadLog, ReparentMonad(grabbedMonad, selectedMonad) ? "Moved [" : "Cannot move [");
+                        AppendLogName(monadLog, grabbedMonad);
+                        strcat(monadLog, "] into [");
+                        AppendLogName(monadLog, selectedMonad);
+                        strcat(monadLog, "].");
+                        grabbedMonad = 0;
+                        selectedLink = 0; //links may have been made anew.
+                    }
                 }
                 else if (IsKeyPressed(KEY_C) || isCutting)
                 {
                     BeginDrawing();
                     DrawText("COPYING", screenHeight/2 - 100, screenWidth/2 - 100, 48, ORANGE);
                     EndDrawing();
-                    char* out = malloc(1);
-                    out[0] = '\0';
-                    PrintMonadsRecursive(selectedMonad , selectedMonad , &out);
-                    SetClipboardText(out);
-                    free(out);
+                    TextBuilder out = { 0 };
+                    AncestorIndex ancestors = BuildAncestorIndex(selectedMonad);
+                    SiblingIndex siblings = BuildSiblingIndex(selectedMonad);
+                    PrintMonadsRecursive(selectedMonad , &ancestors , &siblings , &out);
+                    FreeAncestorIndex(&ancestors);
+                    FreeSiblingIndex(&siblings);
+                    SetClipboardText(out.text);
+                    free(CopiedText);
+                    CopiedText = out.text;
+                    if (CopiedMonad)
+                        FreeDetachedSubtree(CopiedMonad);
+                    CopiedMonad = CloneMonad(selectedMonad, MONAD(selectedMonad, position), 0);
                     if (isCutting)
                     {
                         if (selectedMonad == GodMonad)
                         {
                             strcpy(monadLog, "Cannot cut [");
-                            strcat(monadLog, selectedMonad->name);
+                            AppendLogName(monadLog, selectedMonad);
                             strcat(monadLog, "]: Is root. Copied instead.");
                         }
                         else
                         {
-                            if (!selectedMonad->deleteFrame)
-                            {
-                                strcpy(monadLog, "Cut object [");
-                                strcat(monadLog, selectedMonad->name);
-                                strcat(monadLog, "].");
-                                selectedMonad->deleteFrame = DELETE_PRELINK;
-                            }
-                            selectedMonad = NULL;
+                            strcpy(monadLog, "Cut object [");
+                            AppendLogName(monadLog, selectedMonad);
+                            strcat(monadLog, "].");
+                            RemoveMonad(selectedMonad, MONAD(selectedMonad, container));
+                            selectedMonad = 0;
+                            selectedLink = 0;
+                            grabbedMonad = 0;
                         }
                     }
                     else
                     {
                         strcpy(monadLog, "Copied text data from [");
-                        strcat(monadLog, selectedMonad->name);
+                        AppendLogName(monadLog, selectedMonad);
                         strcat(monadLog, "] to clipboard.");
                     }
                 }
@@ -1113,14 +3317,29 @@ int main(void)
                     BeginDrawing();
                     DrawText("PASTING", screenHeight/2 - 100, screenWidth/2 - 100, 48, ORANGE);
                     EndDrawing();
-                    Monad* pastedOverMonad = AddMonad(mouseV2 , selectedMonad);
-                    InterpretAddMonadsRecursive(pastedOverMonad , GetClipboardText());
-                    InterpretLinksRecursive(pastedOverMonad , (ParentedMonad){NULL , NULL} , GetClipboardText());
+                    const char* clipboard = GetClipboardText();
+                    bool pastingCopy = CopiedMonad && clipboard && !strcmp(clipboard , CopiedText);
+                    MonadId pastedOverMonad;
+                    if (pastingCopy) //still what was copied here, no need to read it back.
+                        pastedOverMonad = CloneMonad(CopiedMonad , mouseV2 , selectedMonad);
+                    else
+                    {
+                        if (CopiedMonad) //the clipboard moved on, the copy will not be pasted again.
+                        {
+                            FreeDetachedSubtree(CopiedMonad);
+                            CopiedMonad = 0;
+                            free(CopiedText);
+                            CopiedText = NULL;
+                        }
+                        pastedOverMonad = AddMonad(mouseV2 , selectedMonad);
+                        InterpretMonads(pastedOverMonad , clipboard);
+                        MONAD_W(pastedOverMonad, position) = mouseV2;
+                    }
                     selectedMonad = pastedOverMonad;
                     selectedMonadDepth++;
-                    pastedOverMonad->position = mouseV2;
-                    strcpy(monadLog, "Pasted text data in [");
-                    strcat(monadLog, selectedMonad->name);
+                    selectedLink = 0; //held by the object pasted into, not by the pasted one.
+                    strcpy(monadLog, pastingCopy ? "Pasted copy in [" : "Pasted text data in [");
+                    AppendLogName(monadLog, selectedMonad);
                     strcat(monadLog, "] from clipboard.");   
                 }
             }
@@ -1133,9 +3352,7 @@ int main(void)
                 else
                 {
                     if (selectedMonad)
-                    {
-                        selectedMonad->name[strlen(selectedMonad->name) - 1] = '\0';
-                    }
+                        EraseNameChar(selectedMonad);
                     backspaceDelay = 5;
                 }
             }
@@ -1145,35 +3362,30 @@ int main(void)
                 int key = GetKeyPressed();
                 if (key && key != KEY_LEFT_SHIFT && key != KEY_RIGHT_SHIFT && key != KEY_LEFT_SUPER && key != KEY_RIGHT_SUPER)
                 {
-                    int nameLength = strlen(selectedMonad->name);
-                    if (nameLength < MAX_MONAD_NAME_SIZE - 1)
+                    bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+                    if (key >= KEY_A && key <= KEY_Z) 
                     {
-                        bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
-                        if (key >= KEY_A && key <= KEY_Z) 
-                        {
-                            char c = 'a' + (key - KEY_A);
-                            if (shift) 
-                            {
-                                c -= 32;
-                            }
-                            key = c;
-                        }
-                        if (key >= KEY_ZERO && key <= KEY_NINE) 
+                        char c = 'a' + (key - KEY_A);
+                        if (shift) 
                         {
-                            if (shift) {
-                                char shifted[] = {')', '!', '@', '#', '$', '%', '^', '&', '*', '('};
-                                key = shifted[key - KEY_ZERO];
-                            } else {
-                                key = '0' + (key - KEY_ZERO);
-                            }
+                            c -= 32;
                         }
-                        if (key == KEY_SPACE) 
-                        {
-                            key = ' ';
+                        key = c;
+                    }
+                    if (key >= KEY_ZERO && key <= KEY_NINE) 
+                    {
+                        if (shift) {
+                            char shifted[] = {')', '!', '@', '#', '$', '%', '^', '&', '*', '('};
+                            key = shifted[key - KEY_ZERO];
+                        } else {
+                            key = '0' + (key - KEY_ZERO);
                         }
-                        selectedMonad->name[nameLength] = (char)key;
-                        selectedMonad->name[nameLength + 1] = '\0';
                     }
+                    if (key == KEY_SPACE) 
+                    {
+                        key = ' ';
+                    }
+                    TypeNameChar(selectedMonad, (char)key);
                 }
             }
         }
@@ -1193,8 +3405,8 @@ int main(void)
         {
             int determineMode = selectedMonadDepth - selectedDepth;
             DrawText((!determineMode) ? "Adding" : (determineMode == 1) ? "Linking" : "Edit Only", 32, 32, 20, SKYBLUE);
-            DrawPoly(selectedMonad->position, 3, 10.0f, 0, Fade(RED, 0.5f));
-            DrawText(selectedMonad->name, (int)selectedMonad->position.x + 10, (int)selectedMonad->position.y + 10, selectedDepth < selectedMonadDepth ? 16 : 24, Fade(ORANGE, 0.5f));
+            DrawPoly(MONAD(selectedMonad, position), 3, 10.0f, 0, Fade(RED, 0.5f));
+            DrawText(MonadNameText(selectedMonad), (int)MONAD(selectedMonad, position).x + 10, (int)MONAD(selectedMonad, position).y + 10, selectedDepth < selectedMonadDepth ? 16 : 24, Fade(ORANGE, 0.5f));
         }
         else
         {
@@ -1205,15 +3417,15 @@ int main(void)
         {
             DrawText("Edit Link", 32, 64, 20, PURPLE);
             Vector2 linkLocation;
-            Vector2 endV2 = selectedLink->endMonad->position;
-            Vector2 endNextV2 = selectedLink->endMonad->next->position;
-            if (selectedLink->startMonad == selectedLink->endMonad)
+            Vector2 endV2 = MONAD(LINK(selectedLink)->endMonad, position);
+            Vector2 endNextV2 = MONAD(MONAD(LINK(selectedLink)->endMonad, next), position);
+            if (LINK(selectedLink)->startMonad == LINK(selectedLink)->endMonad)
             {
-                linkLocation = selectedLink->startMonad->position;
+                linkLocation = MONAD(LINK(selectedLink)->startMonad, position);
             }
             else
             {
-                linkLocation = DrawDualBeziers(selectedLink->startMonad->position , selectedLink->endMonad->position , Fade(RED, 0.5f) , Fade(SameCategory(selectedLink->endMonad, selectedLink->startMonad) ? RED : PURPLE, 0.5f) , 3.5 , 1.5f);
+                linkLocation = DrawDualBeziers(MONAD(LINK(selectedLink)->startMonad, position) , MONAD(LINK(selectedLink)->endMonad, position) , Fade(RED, 0.5f) , Fade(SameCategory(LINK(selectedLink)->endMonad, LINK(selectedLink)->startMonad) ? RED : PURPLE, 0.5f) , 3.5 , 1.5f);
             }
             linkLocation.x -= 12.0f;
             linkLocation.y -= 12.0f;
@@ -1221,6 +3433,18 @@ int main(void)
             DrawLineV(endV2, Vector2Add(endNextV2, Vector2Scale(Vector2Subtract(endV2, endNextV2), 0.9f)), ORANGE);
         }
 
+        char slabText[32];
+        snprintf(slabText, sizeof(slabText), "Slabs: %u", LiveSlabCount);
+        DrawText(slabText, 32, screenHeight - 32, 20, GRAY);
+        if (showMemoryUsage)
+        {
+            DrawMemoryUsage("Total", GodMonad, screenHeight - 64);
+            if (selectedMonad)
+                DrawMemoryUsage("Selected", selectedMonad, screenHeight - 96);
+            if (CopiedMonad)
+                DrawMemoryUsage("Copy", CopiedMonad, screenHeight - 128);
+        }
+
         for (unsigned int m = 1, d = 1; m <= selectedDepth; m *= 10, d++)
         {
             char digit[2] = { '0' + (selectedDepth / m) % 10 ,  0 };
@@ -1238,10 +3462,12 @@ int main(void)
                     else if (selectedDepth && mainResult.resultDepth <= selectedDepth)
                         selectedDepth--;
                 }
+                if (selectedMonad != mainResult.resultMonad)
+                    MonadJournal.sealed = true; //moves of another object are another action.
                 selectedMonad = mainResult.resultMonad;
                 selectedMonadDepth = mainResult.resultDepth;
                 selectedLink = mainResult.resultLink;
-                printf("Object %p, Link %p\n", selectedMonad, selectedLink);
+                printf("Object %u, Link %u\n", selectedMonad, selectedLink);
             break;
             case RESULT_RCLICK:
                 if (selectedMonad)
@@ -1255,9 +3481,9 @@ int main(void)
                         if (selectedLink)
                         {
                             strcpy(monadLog, "Added link [");
-                            strcat(monadLog, selectedLink->startMonad->name);
+                            AppendLogName(monadLog, LINK(selectedLink)->startMonad);
                             strcat(monadLog, "] to [");
-                            strcat(monadLog, selectedLink->endMonad->name);
+                            AppendLogName(monadLog, LINK(selectedLink)->endMonad);
                             strcat(monadLog, "].");
                         }
                         else
@@ -1269,31 +3495,31 @@ int main(void)
                             selectedMonad = mainResult.resultMonad;
                             selectedMonadDepth = mainResult.resultDepth;
                         }
-                        selectedLink = NULL;
+                        selectedLink = 0;
                     }
                     else if (selectedDepth == selectedMonadDepth)
                     {
-                        if (!mainResult.resultMonad && Vector2Distance(selectedMonad->position, mouseV2) >= 30.0f /*deny if too close to container.*/)
+                        if (!mainResult.resultMonad && Vector2Distance(MONAD(selectedMonad, position), mouseV2) >= 30.0f /*deny if too close to container.*/)
                         {
                             strcpy(monadLog, "Added object [");
-                            Monad* newMonad = AddMonad(mouseV2, selectedMonad);
+                            MonadId newMonad = AddMonad(mouseV2, selectedMonad);
                             if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT))
                             {
                                 selectedMonad = newMonad;
                                 selectedMonadDepth++;
-                                selectedLink = NULL;
+                                selectedLink = 0;
                             }
-                            strcat(monadLog, newMonad->name);
+                            AppendLogName(monadLog, newMonad);
                             strcat(monadLog, "].");
                         }
-                        else if (selectedLink && selectedMonadDepth + 1 == mainResult.resultDepth && selectedLink->endMonad != mainResult.resultMonad)
+                        else if (selectedLink && selectedMonadDepth + 1 == mainResult.resultDepth && LINK(selectedLink)->endMonad != mainResult.resultMonad)
                         {
-                            Link* newLink = AddLink(selectedLink->startMonad , mainResult.resultMonad , selectedMonad );
+                            LinkId newLink = AddLink(LINK(selectedLink)->startMonad , mainResult.resultMonad , selectedMonad );
                             if (newLink && RemoveLink(selectedLink , selectedMonad))
                             {
                                 selectedLink = newLink;
                                 strcpy(monadLog, "Changed link end object to [");
-                                strcat(monadLog, selectedLink->endMonad->name);
+                                AppendLogName(monadLog, LINK(selectedLink)->endMonad);
                                 strcat(monadLog, "].");
                             }
                         }
@@ -1301,14 +3527,18 @@ int main(void)
                 }
         }
 
-        if (selectedMonad && IsMouseButtonDown(MOUSE_BUTTON_LEFT) && (selectDrag || Vector2Distance(selectedMonad->position, mouseV2) <= 30.0f))
+        if (selectedMonad && IsMouseButtonDown(MOUSE_BUTTON_LEFT) && (selectDrag || Vector2Distance(MONAD(selectedMonad, position), mouseV2) <= 30.0f))
         {
             if (IsVector2OnScreen(mouseV2))
-                selectedMonad->position = mouseV2;
+                MoveMonad(selectedMonad, mouseV2);
             selectDrag = true;
         }
         else
+        {
+            if (selectDrag)
+                MonadJournal.sealed = true; //the drag has ended, the next one is undone on its own.
             selectDrag = false;
+        }
 
         float mouseMove = GetMouseWheelMove();
         if (mouseMove != 0)
@@ -1322,7 +3552,11 @@ int main(void)
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
-    RemoveSubMonadsRecursive(GodMonad); // Free every object and link from memory.
+    while (GlobalArena.subArenas)
+        ReleaseMonadArena(GlobalArena.subArenas);
+    PoolReleaseAll(&GlobalArena.monads); // Free every object and link from memory in bulk.
+    PoolReleaseAll(&GlobalArena.links);
+    free(CopiedText);
     CloseWindow(); // Close window and OpenGL context
     //--------------------------------------------------------------------------------------
 